@@ -0,0 +1,93 @@
+// Benchmark for the compact brick encoding (see src/brick_grid.h)
+// Fills grids from 1k to 10M bricks and reports bytes per brick
+//  against one heap-allocated `struct brick` per brick as in `struct game`
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "brick_grid.h"
+#include "game.h"
+#include "nsec.h"
+#include "rand.h"
+
+// Same as the bricks made in `game_setup`
+#define BRICK_SIZE_X 380.0
+#define BRICK_SIZE_Y 190.0
+#define BRICK_MARGIN 10.0
+
+// malloc bookkeeping per allocation on 64-bit glibc (at least)
+#define MALLOC_OVERHEAD 16
+
+static void run(const unsigned int side, struct rand_state *const rand) {
+	struct brick_grid grid;
+	brick_grid_init(&grid, 0.0, 0.0,
+		BRICK_SIZE_X, BRICK_SIZE_Y, BRICK_MARGIN, BRICK_MARGIN, side, side);
+
+	const unsigned int num_cells = brick_grid_num_cells(&grid);
+
+	const uint64_t fill_start = nsec_time();
+
+	for (unsigned int i = 0; i < num_cells; i += 1) {
+		const struct brick brick = {
+			.inner_tex_index = rand_state_next(rand) % GAME_NUM_BRICK_TEXS,
+			.inner_tex_x_prop = rand_state_double01(rand),
+			.inner_tex_y_prop = rand_state_double01(rand),
+			.inner_tex_w = rand_state_int(rand, 200, 400),
+			.inner_tex_x_prop_speed =
+				rand_state_double(rand, -1.0, 1.0) * BRICK_GRID_MAX_SPEED,
+			.inner_tex_y_prop_speed =
+				rand_state_double(rand, -1.0, 1.0) * BRICK_GRID_MAX_SPEED
+		};
+
+		brick_grid_set(&grid, i, &brick);
+	}
+
+	const uint64_t fill_ns = nsec_time() - fill_start;
+
+	// Make every brick on demand, as a renderer or collision pass would
+	const uint64_t get_start = nsec_time();
+	double checksum = 0.0;
+
+	for (unsigned int i = 0; i < num_cells; i += 1) {
+		struct brick brick;
+		brick_grid_get(&grid, i, &brick);
+
+		checksum += brick.pos_x + brick.pos_y + brick.inner_tex_x_prop_speed;
+	}
+
+	const uint64_t get_ns = nsec_time() - get_start;
+
+	const double grid_bytes = brick_grid_bytes(&grid);
+	const double heap_bytes = (double)num_cells
+		* (sizeof(struct brick*) + sizeof(struct brick) + MALLOC_OVERHEAD);
+
+	printf("%9u bricks: grid %8.2f MB (%5.2f B/brick)"
+		"  struct game %8.2f MB (%5.1f B/brick)"
+		"  fill %5.1f ns/brick  get %5.1f ns/brick  (%g)\n",
+		grid.num_bricks,
+		grid_bytes / 1000000.0, grid_bytes / grid.num_bricks,
+		heap_bytes / 1000000.0, heap_bytes / num_cells,
+		(double)fill_ns / num_cells,
+		(double)get_ns / num_cells,
+		checksum);
+
+	brick_grid_deinit(&grid);
+}
+
+int main(void) {
+	struct rand_state rand;
+	rand_state_seed(&rand, 1);
+
+	printf("sizeof(struct brick): %zu  sizeof(struct brick_cell): %zu\n",
+		sizeof(struct brick), sizeof(struct brick_cell));
+
+	// Square grids of about 1k, 10k, 100k, 1M, and 10M bricks
+	const unsigned int sides[] = {32, 100, 317, 1000, 3163};
+
+	for (unsigned int i = 0; i < sizeof(sides) / sizeof(sides[0]); i += 1) {
+		run(sides[i], &rand);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+// Benchmark for testing a ball against many bricks (see src/collide.h)
+// First checks that `collide_boxes_test` gives the same result as
+//  `collide_rects` for every rect, including ones that only touch.
+//  Exits with failure if not
+// Then scans brick grids from 100 to 100k bricks for one ball at a time
+//  both ways, as `find_brick_contact` in game.c does
+// Build with COLLIDE_FLAG=-DCOLLIDE_SCALAR to check the scalar fallback
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "collide.h"
+#include "easy_alloc.h"
+#include "game.h"
+#include "nsec.h"
+#include "rand.h"
+
+// Same as the bricks made in `game_setup`
+#define BRICK_SIZE_X 380.0
+#define BRICK_SIZE_Y 190.0
+#define BRICK_MARGIN 10.0
+
+// Same size as the ball made in `game_setup`
+#define BALL_SIZE_X 137.9257
+#define BALL_SIZE_Y 300.0
+
+// Rects tested against each other for the equivalence check
+#define CHECK_NUM_RECTS 1001
+#define CHECK_NUM_BALLS 2000
+
+// Ball positions per grid size for the timing
+#define NUM_BALLS 256
+
+// A rect with a corner and size on a coarse grid half the time,
+//  so that edges often line up exactly
+static void rand_rect(
+	struct rand_state *const rand,
+	double *const x,
+	double *const y,
+	double *const w,
+	double *const h)
+{
+	if (rand_state_next(rand) % 2 == 0) {
+		*x = rand_state_int(rand, -8, 8) * 25.0;
+		*y = rand_state_int(rand, -8, 8) * 25.0;
+		*w = rand_state_int(rand, 0, 8) * 25.0;
+		*h = rand_state_int(rand, 0, 8) * 25.0;
+	}
+	else {
+		*x = rand_state_double(rand, -200.0, 200.0);
+		*y = rand_state_double(rand, -200.0, 200.0);
+		*w = rand_state_double(rand, 0.0, 200.0);
+		*h = rand_state_double(rand, 0.0, 200.0);
+	}
+}
+
+// Returns the number of mismatches
+static unsigned int check(struct rand_state *const rand) {
+	double *const a = easy_malloc(sizeof(double) * 4 * CHECK_NUM_RECTS);
+
+	struct collide_boxes boxes;
+	collide_boxes_init(&boxes);
+	collide_boxes_resize(&boxes, CHECK_NUM_RECTS);
+
+	for (unsigned int i = 0; i < CHECK_NUM_RECTS; i += 1) {
+		double *const r = &a[4 * i];
+		rand_rect(rand, &r[0], &r[1], &r[2], &r[3]);
+
+		collide_boxes_set(&boxes, i, r[0], r[1], r[2], r[3]);
+	}
+
+	unsigned int num_hits = 0;
+	unsigned int num_mismatches = 0;
+
+	for (unsigned int j = 0; j < CHECK_NUM_BALLS; j += 1) {
+		double bx, by, bw, bh;
+		rand_rect(rand, &bx, &by, &bw, &bh);
+
+		for (unsigned int first = 0; first < CHECK_NUM_RECTS;
+			first += COLLIDE_LANES)
+		{
+			uint8_t colls[COLLIDE_LANES];
+			const unsigned int hits =
+				collide_boxes_test(&boxes, first, bx, by, bw, bh, colls);
+
+			for (unsigned int k = 0; k < COLLIDE_LANES; k += 1) {
+				const unsigned int i = first + k;
+
+				// Boxes past the end must never hit
+				const enum collision want = (i < CHECK_NUM_RECTS)
+					? collide_rects(a[4 * i], a[4 * i + 1],
+						a[4 * i + 2], a[4 * i + 3], bx, by, bw, bh)
+					: COLL_NONE;
+
+				const bool hit = (hits >> k) & 1;
+
+				if (hit != (want != COLL_NONE) || (hit && colls[k] != want)) {
+					num_mismatches += 1;
+				}
+
+				num_hits += hit;
+			}
+		}
+	}
+
+	printf("check: %u tests, %u hits, %u mismatches\n",
+		CHECK_NUM_RECTS * CHECK_NUM_BALLS, num_hits, num_mismatches);
+
+	collide_boxes_deinit(&boxes);
+	easy_free(a);
+
+	return num_mismatches;
+}
+
+static void run(const unsigned int side, struct rand_state *const rand) {
+	const unsigned int num = side * side;
+
+	struct brick *const brick_buf = easy_malloc(sizeof(struct brick) * num);
+	struct brick **const bricks = easy_malloc(sizeof(struct brick*) * num);
+
+	struct collide_boxes boxes;
+	collide_boxes_init(&boxes);
+	collide_boxes_resize(&boxes, num);
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		brick_buf[i] = (struct brick) {
+			.pos_x = (i % side) * (BRICK_SIZE_X + BRICK_MARGIN),
+			.pos_y = (i / side) * (BRICK_SIZE_Y + BRICK_MARGIN),
+			.size_x = BRICK_SIZE_X,
+			.size_y = BRICK_SIZE_Y
+		};
+		bricks[i] = &brick_buf[i];
+
+		collide_boxes_set(&boxes, i, brick_buf[i].pos_x, brick_buf[i].pos_y,
+			brick_buf[i].size_x, brick_buf[i].size_y);
+	}
+
+	const double area_x = side * (BRICK_SIZE_X + BRICK_MARGIN);
+	const double area_y = side * (BRICK_SIZE_Y + BRICK_MARGIN);
+
+	double ball_x[NUM_BALLS];
+	double ball_y[NUM_BALLS];
+
+	for (unsigned int j = 0; j < NUM_BALLS; j += 1) {
+		ball_x[j] = rand_state_double(rand, 0.0, area_x);
+		ball_y[j] = rand_state_double(rand, 0.0, area_y);
+	}
+
+	// Every brick for every ball, counting hits so none are skipped
+	unsigned long scalar_hits = 0;
+	const uint64_t scalar_start = nsec_time();
+
+	for (unsigned int j = 0; j < NUM_BALLS; j += 1) {
+		for (unsigned int i = 0; i < num; i += 1) {
+			const struct brick *const brick = bricks[i];
+
+			scalar_hits += collide_rects(
+				brick->pos_x, brick->pos_y, brick->size_x, brick->size_y,
+				ball_x[j], ball_y[j], BALL_SIZE_X, BALL_SIZE_Y) != COLL_NONE;
+		}
+	}
+
+	const uint64_t scalar_ns = nsec_time() - scalar_start;
+
+	unsigned long boxes_hits = 0;
+	const uint64_t boxes_start = nsec_time();
+
+	for (unsigned int j = 0; j < NUM_BALLS; j += 1) {
+		for (unsigned int first = 0; first < num; first += COLLIDE_LANES) {
+			uint8_t colls[COLLIDE_LANES];
+			const unsigned int hits = collide_boxes_test(&boxes, first,
+				ball_x[j], ball_y[j], BALL_SIZE_X, BALL_SIZE_Y, colls);
+
+			for (unsigned int k = 0; k < COLLIDE_LANES; k += 1) {
+				boxes_hits += (hits >> k) & 1;
+			}
+		}
+	}
+
+	const uint64_t boxes_ns = nsec_time() - boxes_start;
+
+	const double num_tests = (double)num * NUM_BALLS;
+
+	printf("%7u bricks | collide_rects %6.2f ns/brick | "
+		"collide_boxes_test %6.2f ns/brick | %5.2fx | hits %lu %lu\n",
+		num,
+		scalar_ns / num_tests,
+		boxes_ns / num_tests,
+		boxes_ns > 0 ? (double)scalar_ns / boxes_ns : 0.0,
+		scalar_hits, boxes_hits);
+
+	collide_boxes_deinit(&boxes);
+	easy_free(bricks);
+	easy_free(brick_buf);
+}
+
+int main(void) {
+	struct rand_state rand;
+	rand_state_seed(&rand, 1);
+
+	if (check(&rand) != 0) {
+		fprintf(stderr, "%s: collide_boxes_test and collide_rects differ\n",
+			__func__);
+		return EXIT_FAILURE;
+	}
+
+	// About 100, 1k, 10k, and 100k bricks
+	const unsigned int sides[] = {10, 32, 100, 317};
+
+	for (unsigned int i = 0; i < sizeof(sides) / sizeof(sides[0]); i += 1) {
+		run(sides[i], &rand);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+// Benchmark for the event-driven engine (see src/evsim.h)
+// Plays an hour of game time from several seeds with evsim and its
+//  auto paddle, then with fixed 60 Hz steps and sim's paddle controller,
+//  and prints how long each took and how the games went
+// Exits with failure if evsim loses more balls than the fixed steps,
+//  which means its auto paddle is going for the wrong place
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "evsim.h"
+#include "game.h"
+#include "nsec.h"
+#include "phases.h"
+
+#define GAME_SECONDS 3600.0
+#define STEP_NS 16667000
+
+#define NUM_SEEDS 4
+
+struct bench_result {
+	uint64_t wall_ns;
+	unsigned int levels_cleared;
+	unsigned int ball_deaths;
+};
+
+// Same loop as `run_evsim` in sim.c
+static struct bench_result run_evsim(const uint64_t seed) {
+	struct game game;
+	game_init(&game);
+	game_seed(&game, seed);
+	game_setup(&game);
+
+	struct evsim sim;
+	evsim_init(&sim);
+	sim.auto_paddle = true;
+
+	struct bench_result result = {0};
+	const double end_ns = GAME_SECONDS * 1000000000.0;
+	double time = 0.0;
+
+	const uint64_t start = nsec_time();
+
+	while (time < end_ns) {
+		evsim_begin(&sim, &game);
+
+		const enum evsim_result run = evsim_run_until(&sim, end_ns - time);
+
+		time += sim.time;
+		result.ball_deaths += sim.stats.ball_deaths;
+
+		evsim_end(&sim);
+
+		if (run == EVSIM_LEVEL_CLEARED) {
+			result.levels_cleared += 1;
+		}
+
+		if (run != EVSIM_REACHED_TIME) {
+			game_setup(&game);
+		}
+	}
+
+	result.wall_ns = nsec_time() - start;
+
+	evsim_deinit(&sim);
+	game_desetup(&game);
+	game_deinit(&game);
+
+	return result;
+}
+
+// Same loop as `run_fixed` in sim.c
+static struct bench_result run_fixed(const uint64_t seed) {
+	struct game game;
+	game_init(&game);
+	game_seed(&game, seed);
+	game.parallel = false;
+	game_setup(&game);
+
+	struct bench_result result = {0};
+	uint64_t phase_ticks[NUM_PHASES] = {0};
+	const uint64_t num_steps = GAME_SECONDS * 1000000000.0 / STEP_NS;
+
+	const uint64_t start = nsec_time();
+
+	for (uint64_t i = 0; i < num_steps; i += 1) {
+		const bool dead = game.num_balls == 0 && game.particles.num == 0;
+		const bool level_cleared =
+			game.num_bricks == 0 && game.particles.num == 0;
+
+		if (level_cleared) {
+			result.levels_cleared += 1;
+		}
+
+		if (dead || level_cleared) {
+			game_setup(&game);
+		}
+
+		const unsigned int num_balls = game.num_balls;
+		phases_step(&game, STEP_NS, NULL, phase_ticks);
+		result.ball_deaths += num_balls - game.num_balls;
+	}
+
+	result.wall_ns = nsec_time() - start;
+
+	game_desetup(&game);
+	game_deinit(&game);
+
+	return result;
+}
+
+int main(void) {
+	nsec_calibrate();
+
+	bool failed = false;
+
+	for (uint64_t seed = 1; seed <= NUM_SEEDS; seed += 1) {
+		const struct bench_result ev = run_evsim(seed);
+		const struct bench_result fixed = run_fixed(seed);
+
+		printf("seed %lu | evsim %8.3f ms, %3u levels, %3u deaths | "
+			"fixed %8.3f ms, %3u levels, %3u deaths | %6.1fx\n",
+			(unsigned long)seed,
+			ev.wall_ns / 1000000.0, ev.levels_cleared, ev.ball_deaths,
+			fixed.wall_ns / 1000000.0, fixed.levels_cleared,
+			fixed.ball_deaths,
+			ev.wall_ns > 0 ? (double)fixed.wall_ns / ev.wall_ns : 0.0);
+
+		if (ev.ball_deaths > fixed.ball_deaths) {
+			failed = true;
+		}
+	}
+
+	if (failed) {
+		fprintf(stderr, "%s: evsim's auto paddle lost more balls than "
+			"fixed steps\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// Benchmark for brick texture mip levels (see src/mip.h)
+// Draws a screen of bricks with SDL's software renderer, sampling each
+//  brick's texture window from level 0 and then from the level that
+//  `mip_level` picks, and reports the time per frame and texels read
+// Uses a generated texture, so the assets are not needed
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "mip.h"
+#include "nsec.h"
+#include "rand.h"
+#include "sdlu.h"
+
+// The default window
+#define SCREEN_W 640
+#define SCREEN_H 840
+
+// Bricks as `game_setup` makes them in the default window:
+//  about 76 by 38 pixels with a 4 pixel border
+#define NUM_COLUMNS 8
+#define NUM_ROWS 12
+#define BRICK_W 76
+#define BRICK_H 38
+#define BORDER 4
+
+#define TEX_SIZE 1024
+
+#define NUM_FRAMES 200
+
+struct bench_brick {
+	SDL_Rect dst;
+	SDL_Rect src;// In level 0
+};
+
+static SDL_Surface *make_noise_surface(struct rand_state *const rand) {
+	SDL_Surface *const surface = sdlu_create_rgb_surface_with_format(
+		TEX_SIZE, TEX_SIZE, SDL_PIXELFORMAT_RGBA32);
+
+	sdlu_lock_surface(surface);
+
+	for (int y = 0; y < surface->h; y += 1) {
+		uint8_t *const row = (uint8_t*)surface->pixels + y * surface->pitch;
+
+		for (int x = 0; x < 4 * surface->w; x += 1) {
+			row[x] = rand_state_next(rand);
+		}
+	}
+
+	SDL_UnlockSurface(surface);
+
+	return surface;
+}
+
+// Returns nanoseconds per frame. Adds the texels read per frame to `texels`
+static double run(
+	SDL_Renderer *const renderer,
+	SDL_Texture *const *const levels,
+	const unsigned int num_levels,
+	const struct bench_brick *const bricks,
+	const unsigned int num_bricks,
+	uint64_t *const texels)
+{
+	*texels = 0;
+
+	for (unsigned int i = 0; i < num_bricks; i += 1) {
+		const unsigned int level =
+			mip_level(bricks[i].src.w, bricks[i].dst.w, num_levels);
+		const SDL_Rect src = mip_rect(bricks[i].src, level);
+
+		*texels += (uint64_t)src.w * src.h;
+	}
+
+	const uint64_t start = nsec_time();
+
+	for (unsigned int frame = 0; frame < NUM_FRAMES; frame += 1) {
+		sdlu_render_clear(renderer);
+
+		for (unsigned int i = 0; i < num_bricks; i += 1) {
+			const unsigned int level =
+				mip_level(bricks[i].src.w, bricks[i].dst.w, num_levels);
+			const SDL_Rect src = mip_rect(bricks[i].src, level);
+
+			sdlu_render_copy(renderer, levels[level], &src, &bricks[i].dst);
+		}
+
+		SDL_RenderPresent(renderer);
+	}
+
+	return (double)(nsec_time() - start) / NUM_FRAMES;
+}
+
+int main(void) {
+	sdlu_init(SDL_INIT_VIDEO);
+
+	struct rand_state rand;
+	rand_state_seed(&rand, 1);
+
+	SDL_Surface *const screen = sdlu_create_rgb_surface_with_format(
+		SCREEN_W, SCREEN_H, SDL_PIXELFORMAT_RGBA32);
+	SDL_Renderer *const renderer = SDL_CreateSoftwareRenderer(screen);
+
+	if (renderer == NULL) {
+		fprintf(stderr, "%s: Error: %s\n", __func__, SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Surface *const noise = make_noise_surface(&rand);
+	SDL_Texture *levels[MIP_MAX_LEVELS];
+	const unsigned int num_levels =
+		mip_create_textures(renderer, noise, levels);
+	SDL_FreeSurface(noise);
+
+	struct bench_brick bricks[NUM_COLUMNS * NUM_ROWS];
+	const unsigned int num_bricks = NUM_COLUMNS * NUM_ROWS;
+
+	for (unsigned int i = 0; i < num_bricks; i += 1) {
+		const int column = i % NUM_COLUMNS;
+		const int row = i / NUM_COLUMNS;
+		// Same range as `inner_tex_w` in `game_setup`
+		const int src_w = rand_state_int(&rand, 200, 400);
+		const int src_h = src_w * BRICK_H / BRICK_W;
+
+		bricks[i] = (struct bench_brick) {
+			.dst = {
+				.x = column * (BRICK_W + 4) + BORDER,
+				.y = row * (BRICK_H + 4) + BORDER,
+				.w = BRICK_W - 2 * BORDER,
+				.h = BRICK_H - 2 * BORDER
+			},
+			.src = {
+				.x = rand_state_int(&rand, 0, TEX_SIZE - src_w),
+				.y = rand_state_int(&rand, 0, TEX_SIZE - src_h),
+				.w = src_w,
+				.h = src_h
+			}
+		};
+	}
+
+	printf("%u bricks, %d by %d pixels, %u mip levels\n",
+		num_bricks, BRICK_W - 2 * BORDER, BRICK_H - 2 * BORDER, num_levels);
+
+	uint64_t texels;
+	const double full_ns = run(renderer, levels, 1, bricks, num_bricks, &texels);
+	printf("level 0 only: %8.1f us/frame  %9lu texels/frame\n",
+		full_ns / 1000.0, (unsigned long)texels);
+
+	const double mip_ns =
+		run(renderer, levels, num_levels, bricks, num_bricks, &texels);
+	printf("mip levels:   %8.1f us/frame  %9lu texels/frame\n",
+		mip_ns / 1000.0, (unsigned long)texels);
+
+	for (unsigned int level = 0; level < num_levels; level += 1) {
+		SDL_DestroyTexture(levels[level]);
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(screen);
+	SDL_Quit();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+// Benchmark for particle collisions (see src/rect_hash.h)
+// Fills a large level with 1k to 1M particles falling onto the bricks
+//  and times `game_update_particles` with and without
+//  `game.particle_collisions`, and the build of the hash of bricks on
+//  its own
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "nsec.h"
+#include "particles.h"
+#include "rand.h"
+#include "rect_hash.h"
+
+// About 4000 bricks, like perfcheck's big_level
+#define PLAY_AREA_SIZE_X 30000.0
+#define PLAY_AREA_SIZE_Y 40000.0
+
+// Frames per run at 60 Hz. Less than the particle lifetime
+#define NUM_FRAMES 60
+#define FRAME_NS 16666667
+
+// Particle sizes and speeds, a bit like those of a broken brick
+#define PARTICLE_MIN_SIZE 20.0
+#define PARTICLE_MAX_SIZE 120.0
+#define PARTICLE_MAX_SPEED 0.000004
+
+static void spawn(
+	struct game *const game,
+	const unsigned int num,
+	struct rand_state *const rand)
+{
+	const double left = game->play_area_origin_x - PLAY_AREA_SIZE_X / 2.0;
+	const double bottom = game->play_area_origin_y - PLAY_AREA_SIZE_Y / 2.0;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		struct particle *const particle = particles_spawn(&game->particles);
+
+		particle->size_x = rand_state_double(rand,
+			PARTICLE_MIN_SIZE, PARTICLE_MAX_SIZE);
+		particle->size_y = rand_state_double(rand,
+			PARTICLE_MIN_SIZE, PARTICLE_MAX_SIZE);
+		particle->pos_x = left + rand_state_double(rand, 0.0, PLAY_AREA_SIZE_X);
+		particle->pos_y = bottom + rand_state_double(rand, 0.0, PLAY_AREA_SIZE_Y);
+		particle->vel_x = rand_state_double(rand,
+			-PARTICLE_MAX_SPEED, PARTICLE_MAX_SPEED);
+		particle->vel_y = rand_state_double(rand,
+			-PARTICLE_MAX_SPEED, PARTICLE_MAX_SPEED);
+
+		particle->r = 255;
+		particle->g = 255;
+		particle->b = 255;
+		particle->a = 255;
+	}
+}
+
+// Returns ns per frame of `game_update_particles`
+// Sets `out_resting` to how many particles ended up at rest on something
+static double run_frames(
+	struct game *const game,
+	const unsigned int num,
+	const bool collisions,
+	unsigned int *const out_resting)
+{
+	struct rand_state rand;
+	rand_state_seed(&rand, 2);
+
+	particles_clear(&game->particles);
+	spawn(game, num, &rand);
+
+	game->particle_collisions = collisions;
+
+	const uint64_t start = nsec_time();
+
+	for (unsigned int f = 0; f < NUM_FRAMES; f += 1) {
+		game_update_particles(game, FRAME_NS);
+	}
+
+	const uint64_t ns = nsec_time() - start;
+
+	*out_resting = 0;
+
+	for (unsigned int i = 0; i < game->particles.num; i += 1) {
+		game_scalar vel_x;
+		game_scalar vel_y;
+		particles_velocity(&game->particles,
+			particles_get(&game->particles, i), &vel_x, &vel_y);
+
+		// Still falling from rest for part of the last frame at most
+		*out_resting += vel_y <= 0.0
+			&& vel_y > -PARTICLES_GRAVITY * FRAME_NS;
+	}
+
+	return (double)ns / NUM_FRAMES;
+}
+
+static void run(struct game *const game, const unsigned int num) {
+	unsigned int resting_off;
+	unsigned int resting_on;
+
+	const double off_ns = run_frames(game, num, false, &resting_off);
+	const double on_ns = run_frames(game, num, true, &resting_on);
+
+	// The hash on its own, of the rects of the last update
+	const uint64_t start = nsec_time();
+
+	for (unsigned int f = 0; f < NUM_FRAMES; f += 1) {
+		rect_hash_build(&game->rect_hash);
+	}
+
+	const double build_ns = (double)(nsec_time() - start) / NUM_FRAMES;
+
+	printf("%8u particles | off %8.3f ms | on %8.3f ms (build %8.3f ms) "
+		"| %7.1f ns/particle | resting %u (%u without)\n",
+		num,
+		off_ns / 1000000.0,
+		on_ns / 1000000.0,
+		build_ns / 1000000.0,
+		on_ns / num,
+		resting_on, resting_off);
+}
+
+int main(void) {
+	nsec_calibrate();
+
+	struct game game;
+	game_init(&game);
+	game_seed(&game, 3);
+
+	game.play_area_size_x = PLAY_AREA_SIZE_X;
+	game.play_area_size_y = PLAY_AREA_SIZE_Y;
+
+	game_setup(&game);
+
+	printf("%u bricks\n", game.num_bricks);
+
+	const unsigned int nums[] = {1000, 10000, 100000, 1000000};
+
+	for (unsigned int i = 0; i < sizeof(nums) / sizeof(nums[0]); i += 1) {
+		run(&game, nums[i]);
+	}
+
+	game_desetup(&game);
+	game_deinit(&game);
+
+	return EXIT_SUCCESS;
+}
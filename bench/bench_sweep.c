@@ -0,0 +1,177 @@
+// Benchmark for the ball-ball sort and sweep broadphase (see src/sweep.h)
+// Scales the number of balls from 10 to 100k at a fixed density
+//  and compares against testing all pairs
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easy_alloc.h"
+#include "game.h"
+#include "nsec.h"
+#include "rand.h"
+#include "sweep.h"
+
+// Same size as the ball made in `game_setup`
+#define BALL_SIZE_X 137.9257
+#define BALL_SIZE_Y 300.0
+
+// How much area each ball gets on average, in ball areas
+#define AREA_PER_BALL 12.0
+
+// Nanoseconds per simulated frame (60 Hz)
+#define FRAME_NS 16666667.0
+
+// Do not test all pairs above this many balls (it takes too long)
+#define MAX_ALL_PAIRS 10000
+
+// Move balls and bounce them off the edges of the square area
+static void step_balls(
+	struct ball *const *const balls,
+	const unsigned int num,
+	const double area_size)
+{
+	for (unsigned int i = 0; i < num; i += 1) {
+		struct ball *const ball = balls[i];
+
+		ball->pos_x += ball->vel_x * FRAME_NS;
+		ball->pos_y += ball->vel_y * FRAME_NS;
+
+		if (ball->pos_x < 0.0) {
+			ball->pos_x = 0.0;
+			ball->vel_x = fabs(ball->vel_x);
+		}
+		else if (ball->pos_x + ball->size_x > area_size) {
+			ball->pos_x = area_size - ball->size_x;
+			ball->vel_x = -fabs(ball->vel_x);
+		}
+
+		if (ball->pos_y - ball->size_y < 0.0) {
+			ball->pos_y = ball->size_y;
+			ball->vel_y = fabs(ball->vel_y);
+		}
+		else if (ball->pos_y > area_size) {
+			ball->pos_y = area_size;
+			ball->vel_y = -fabs(ball->vel_y);
+		}
+	}
+}
+
+// Count overlapping pairs by testing every pair
+static unsigned int count_all_pairs(
+	struct ball *const *const balls,
+	const unsigned int num)
+{
+	unsigned int num_pairs = 0;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const struct ball *const a = balls[i];
+
+		for (unsigned int j = i + 1; j < num; j += 1) {
+			const struct ball *const b = balls[j];
+
+			if (a->pos_x < b->pos_x + b->size_x &&
+			    b->pos_x < a->pos_x + a->size_x &&
+			    a->pos_y - a->size_y < b->pos_y &&
+			    b->pos_y - b->size_y < a->pos_y)
+			{
+				num_pairs += 1;
+			}
+		}
+	}
+
+	return num_pairs;
+}
+
+static void run(const unsigned int num, const unsigned int num_frames) {
+	const double area_size =
+		sqrt(num * AREA_PER_BALL * BALL_SIZE_X * BALL_SIZE_Y);
+
+	struct ball *const ball_buf = easy_malloc(sizeof(struct ball) * num);
+	struct ball **const balls = easy_malloc(sizeof(struct ball*) * num);
+	unsigned int *const order = easy_malloc(sizeof(unsigned int) * num);
+	struct sweep_box *const boxes = easy_malloc(sizeof(struct sweep_box) * num);
+
+	// Place balls column by column so that the starting order is sorted
+	//  (like `game->ball_order` after the first frame)
+	const unsigned int per_column = ceil(sqrt(num));
+	const double cell_x = area_size / per_column;
+	const double cell_y = area_size / per_column;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const unsigned int column = i / per_column;
+		const unsigned int row = i % per_column;
+
+		ball_buf[i] = (struct ball) {
+			.pos_x = fmin(column * cell_x, area_size - BALL_SIZE_X),
+			.pos_y = fmax(row * cell_y, 0.0) + BALL_SIZE_Y,
+			.vel_x = rand_double(-0.000003, 0.000003),
+			.vel_y = rand_double(-0.000003, 0.000003),
+			.size_x = BALL_SIZE_X,
+			.size_y = BALL_SIZE_Y
+		};
+
+		balls[i] = &ball_buf[i];
+		order[i] = i;
+	}
+
+	uint64_t sort_ns = 0;
+	uint64_t sweep_ns = 0;
+	uint64_t all_pairs_ns = 0;
+	unsigned long num_pairs = 0;
+	unsigned long num_all_pairs = 0;
+
+	for (unsigned int f = 0; f < num_frames; f += 1) {
+		step_balls(balls, num, area_size);
+
+		const uint64_t t0 = nsec_time();
+		sweep_sort(balls, order, boxes, num);
+		const uint64_t t1 = nsec_time();
+		num_pairs += sweep_collide(balls, order, boxes, num);
+		const uint64_t t2 = nsec_time();
+
+		sort_ns += t1 - t0;
+		sweep_ns += t2 - t1;
+
+		if (num <= MAX_ALL_PAIRS) {
+			const uint64_t t3 = nsec_time();
+			num_all_pairs += count_all_pairs(balls, num);
+			all_pairs_ns += nsec_time() - t3;
+		}
+	}
+
+	printf("%7u balls | sort %10.1f us | sweep %10.1f us | "
+		"ns/ball %7.1f | pairs/frame %8.1f | ",
+		num,
+		sort_ns / 1000.0 / num_frames,
+		sweep_ns / 1000.0 / num_frames,
+		(double)(sort_ns + sweep_ns) / num_frames / num,
+		(double)num_pairs / num_frames);
+
+	if (num <= MAX_ALL_PAIRS) {
+		// Pushing a pair apart can make new overlaps for the next frame
+		printf("all pairs %10.1f us (%lu overlapping after sweep)\n",
+			all_pairs_ns / 1000.0 / num_frames, num_all_pairs);
+	}
+	else {
+		printf("all pairs (skipped)\n");
+	}
+
+	easy_free(boxes);
+	easy_free(order);
+	easy_free(balls);
+	easy_free(ball_buf);
+}
+
+int main(void) {
+	srand(1);
+
+	const unsigned int nums[] = {10, 100, 1000, 10000, 100000};
+
+	for (unsigned int i = 0; i < sizeof(nums) / sizeof(nums[0]); i += 1) {
+		run(nums[i], 120);
+	}
+
+	return EXIT_SUCCESS;
+}
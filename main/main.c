@@ -1,18 +1,26 @@
-#include <math.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
 #include "charu.h"
+#include "dynres.h"
 #include "easy_alloc.h"
 #include "game.h"
+#include "latency.h"
+#include "mip.h"
 #include "nsec.h"
+#include "pace.h"
+#include "predict.h"
 #include "rand.h"
+#include "replay.h"
 #include "sdlu.h"
+#include "snapshot.h"
 
 // If buf is NULL, prints to stderr and exits
 // Datetime format: yyyy-mm-dd_hh:mm:ss.MMM_UTC
@@ -137,139 +145,277 @@ double clamp_double(const double val, const double min, const double max) {
 	return val;
 }
 
-// Wrap the double around into the [0, 1] range
-double wrap_double01(double value) {
-	if (value > 1.0) {
-		return fmod(value, 1.0);
-	}
+// Input from the render (main) thread for the simulation thread
+// The counters only go up. The sim thread acts on how much each one
+//  changed since it last looked, so no key press is lost or doubled
+struct sim_input {
+	SDL_atomic_t quit;
+	SDL_atomic_t ai_paddle;// Attract mode: paddle is moved by predict.h
+	SDL_atomic_t paddle_x;// Wanted left edge of the paddle in game units
+	// Sequence number (see latency.h) of `paddle_x`
+	// Set after `paddle_x` and read before it
+	SDL_atomic_t paddle_sequence;
+	SDL_atomic_t num_speed_ups;
+	SDL_atomic_t num_speed_downs;
+	SDL_atomic_t num_resets;
+	SDL_atomic_t particle_collisions;// Value for `game.particle_collisions`
+};
 
-	// This can be improved
-	while (value < 0.0) {
-		value += 1.0;
-	}
+// For comparing frames with and without pacing
+struct frame_stats {
+	uint64_t num_frames;
+	uint64_t start_time;
+	uint64_t start_cpu_time;
+	uint64_t start_num_allocs;// Only counted with EASY_ALLOC_TRACK
+};
 
-	return value;
+void frame_stats_start(struct frame_stats *const stats) {
+	struct easy_alloc_stats alloc_stats;
+	easy_alloc_get_stats(&alloc_stats);
+
+	stats->num_frames = 0;
+	stats->start_time = nsec_time();
+	stats->start_cpu_time = nsec_cpu_time();
+	stats->start_num_allocs = alloc_stats.num_allocs;
 }
 
-/* Overlap formula from: https://stackoverflow.com/questions/306316/
-determine-if-two-rectangles-overlap-each-other */
-bool rects_overlap(
-	const double ax,
-	const double ay,
-	const double aw,
-	const double ah,
-	const double bx,
-	const double by,
-	const double bw,
-	const double bh)
+void frame_stats_print(
+	const struct frame_stats *const stats,
+	const bool paced,
+	const double render_scale)
 {
-	// We need right and bottom for both rects
+	if (stats->num_frames == 0) {
+		return;
+	}
 
-	const double ar = ax + aw;
-	const double ab = ay - ah;
+	const double seconds = (nsec_time() - stats->start_time) / 1000000000.0;
+	const double cpu_seconds =
+		(nsec_cpu_time() - stats->start_cpu_time) / 1000000000.0;
+
+	printf("Pacing %s: %lu frames, %.1f fps, CPU %.1f%% of a core, "
+		"render scale %.2f\n",
+		paced ? "on" : "off",
+		(unsigned long)stats->num_frames,
+		stats->num_frames / seconds,
+		100.0 * cpu_seconds / seconds,
+		render_scale);
+
+	if (EASY_ALLOC_TRACKING) {
+		struct easy_alloc_stats alloc_stats;
+		easy_alloc_get_stats(&alloc_stats);
+
+		// Both threads
+		printf("Allocations: %.2f per frame, %zu bytes live, %zu bytes peak\n",
+			(double)(alloc_stats.num_allocs - stats->start_num_allocs)
+				/ stats->num_frames,
+			alloc_stats.live_bytes,
+			alloc_stats.peak_bytes);
+	}
+}
 
-	const double br = bx + bw;
-	const double bb = by - bh;
+// You can't pass around a pointer to 'all the variables in a scope'
+// Pass around a struct instead (is this a good idea?)
+struct world {
+	SDL_Window *window;
+	SDL_Surface *surface;
+	SDL_Renderer *renderer;
 
-	return ax < br && ar > bx && ay > bb && ab < by;
-}
+	bool quit;
+	bool is_fullscreen;
+	bool ai_paddle;
+
+	bool paced;
+	double frames_per_sec;// Refresh rate of the display
+	struct pace pace;
+	struct frame_stats frame_stats;
 
-enum collision {
-	COLL_NONE = 0,
-	COLL_TOP,
-	COLL_RIGHT,
-	COLL_BOTTOM,
-	COLL_LEFT
+	int mouse_x;// Last mouse x sent to the sim thread
+	struct latency latency;
+
+	// When frames take too long, the scene is drawn to `scene` at a lower
+	//  resolution and then stretched over the window
+	struct dynres dynres;
+	SDL_Texture *scene;// NULL until first needed
+	int scene_w;
+	int scene_h;
+
+	// Only touched by the sim thread once it has started
+	struct game game;
+	struct game_textures textures;
+
+	// With `--record FILE`, the input of every step goes into `replay`,
+	//  which is written to FILE at exit. Otherwise NULL
+	const char *record_path;
+	struct replay replay;
+
+	struct sim_input input;
+	struct snapshot_buffer snapshots;
+
+	// Scratch space for converting entities to pixels each frame
+	SDL_Rect *rects;
+	unsigned int rects_len;
+	SDL_FRect *frects;
+	unsigned int frects_len;
+	// For `snapshot_brick_src_rects`
+	SDL_Rect *src_rects;
+	game_scalar *phases;// Twice as long as `src_rects`
+	unsigned int src_rects_len;
 };
 
-/* Based on: https://gamedev.stackexchange.com/questions/29786/a-simple-
-2d-rectangle-collision-algorithm-that-also-determines-which-sides-that */
-// Returns COLL_TOP if b hits the top of a, etc.
-enum collision collide_rects(
-	const double ax,
-	const double ay,
-	const double aw,
-	const double ah,
-	const double bx,
-	const double by,
-	const double bw,
-	const double bh)
-{
-	const double a_center_x = ax + (aw * 0.5);
-	const double a_center_y = ay - (ah * 0.5);
+// Make sure `world->rects` has room for at least `num` rects
+void world_reserve_rects(struct world *const world, const unsigned int num) {
+	if (num <= world->rects_len) {
+		return;
+	}
 
-	const double b_center_x = bx + (bw * 0.5);
-	const double b_center_y = by - (bh * 0.5);
+	world->rects_len = num * 2;
+	world->rects = easy_realloc(
+		world->rects, world->rects_len * sizeof(SDL_Rect));
+}
 
-	const double w = 0.5 * (aw + bw);
-	const double h = 0.5 * (ah + bh);
-	const double dx = a_center_x - b_center_x;
-	const double dy = a_center_y - b_center_y;
+// Make sure `world->frects` has room for at least `num` rects
+void world_reserve_frects(struct world *const world, const unsigned int num) {
+	if (num <= world->frects_len) {
+		return;
+	}
 
-	if (fabs(dx) <= w && fabs(dy) <= h) {
-		const double wy = w * dy;
-		const double hx = h * dx;
+	world->frects_len = num * 2;
+	world->frects = easy_realloc(
+		world->frects, world->frects_len * sizeof(SDL_FRect));
+}
 
-		if (wy > hx) {
-			if (wy > -hx) {
-				return COLL_BOTTOM;
-			}
+// Longest step the sim thread will take (ns)
+// After a longer stall the game skips the extra time instead of jumping
+#define SIM_MAX_DELTA_NS 50000000
 
-			return COLL_RIGHT;
+// Runs the game and publishes a snapshot after every step
+// Never waits on the render thread
+static int sim_thread(void *const data) {
+	struct world *const world = data;
+	struct game *const game = &world->game;
+	struct sim_input *const input = &world->input;
+
+	// How many of each command have been applied
+	int num_speed_ups = 0;
+	int num_speed_downs = 0;
+	int num_resets = 0;
+	int paddle_x = INT_MIN;
+	int paddle_sequence = 0;
+
+	struct nsec_delta clock;
+	nsec_delta_init(&clock, SIM_MAX_DELTA_NS);
+
+	while (!SDL_AtomicGet(&input->quit)) {
+		const uint64_t delta = nsec_delta_next(&clock);
+
+		// Reset game if dead or the level was cleared
+
+		const bool dead =
+			game->num_balls == 0 && game->particles.num == 0;
+		const bool level_cleared =
+			game->num_bricks == 0 && game->particles.num == 0;
+
+		if (dead || level_cleared) {
+			game_setup(game);
 		}
-		else {
-			if (wy > -hx) {
-				return COLL_LEFT;
+
+		// Commands from the render thread
+
+		// Not recorded: it only changes particles (see game.h)
+		game->particle_collisions =
+			SDL_AtomicGet(&input->particle_collisions);
+
+		struct replay_step step = {
+			.delta = delta,
+			.paddle_x = REPLAY_NO_PADDLE,
+			.ai_paddle = SDL_AtomicGet(&input->ai_paddle)
+		};
+
+		const int new_speed_ups = SDL_AtomicGet(&input->num_speed_ups);
+		for (; num_speed_ups != new_speed_ups && step.num_speed_ups < UINT8_MAX;
+			num_speed_ups += 1)
+		{
+			step.num_speed_ups += 1;
+		}
+
+		const int new_speed_downs = SDL_AtomicGet(&input->num_speed_downs);
+		for (; num_speed_downs != new_speed_downs
+			&& step.num_speed_downs < UINT8_MAX; num_speed_downs += 1)
+		{
+			step.num_speed_downs += 1;
+		}
+
+		const int new_resets = SDL_AtomicGet(&input->num_resets);
+		if (num_resets != new_resets) {
+			num_resets = new_resets;
+			step.reset = true;
+		}
+
+		if (!step.ai_paddle) {
+			paddle_sequence = SDL_AtomicGet(&input->paddle_sequence);
+
+			// Only move when the mouse moved, as with mouse motion events
+			const int new_paddle_x = SDL_AtomicGet(&input->paddle_x);
+
+			if (new_paddle_x != paddle_x) {
+				paddle_x = new_paddle_x;
+				step.paddle_x = paddle_x;
 			}
+		}
+
+		// How much delta x movement the paddle did this step
+		const double paddle_dx = replay_apply(game, &step);
 
-			return COLL_TOP;
+		if (world->record_path != NULL) {
+			replay_append(&world->replay, &step);
 		}
-	}
 
-	return COLL_NONE;
-}
+		game_step(game, delta, paddle_dx);
 
-// Populate the `out_` values as a random rect inside the given rect
-void rand_rect_inside_rect(
-	const double pos_x,
-	const double pos_y,
-	const double size_x,
-	const double size_y,
-	double *const out_pos_x,
-	double *const out_pos_y,
-	double *const out_size_x,
-	double *const out_size_y)
-{
-	// Arbitrarily decided that the rect is [0.05, 0.95] of the parent sizes
-	*out_size_x = rand_double(0.05 * size_x, 0.95 * size_x);
-	*out_size_y = rand_double(0.05 * size_y, 0.95 * size_y);
+		struct snapshot *const snapshot =
+			snapshot_buffer_back(&world->snapshots);
+		snapshot_capture(snapshot, game);
+		snapshot->input_sequence = paddle_sequence;
+		snapshot_buffer_publish(&world->snapshots);
 
-	const double parent_right = pos_x + size_x;
-	const double parent_bottom = pos_y - size_y;
+		// Leave the core to the render thread for a moment
+		SDL_Delay(1);
+	}
 
-	*out_pos_x = rand_double(pos_x, parent_right - *out_size_x);
-	*out_pos_y = rand_double(parent_bottom + *out_size_y, pos_y);
+	return 0;
 }
 
-// You can't pass around a pointer to 'all the variables in a scope'
-// Pass around a struct instead (is this a good idea?)
-struct world {
-	SDL_Window *window;
-	SDL_Surface *surface;
-	SDL_Renderer *renderer;
-
-	bool quit;
-	bool is_fullscreen;
+// Make sure `world->src_rects` and `world->phases` have room for `num` bricks
+void world_reserve_src_rects(struct world *const world, const unsigned int num) {
+	if (num <= world->src_rects_len) {
+		return;
+	}
 
-	struct game game;
-};
+	world->src_rects_len = num * 2;
+	world->src_rects = easy_realloc(
+		world->src_rects, world->src_rects_len * sizeof(SDL_Rect));
+	world->phases = easy_realloc(
+		world->phases, 2 * world->src_rects_len * sizeof(game_scalar));
+}
 
-int main(void) {
+// Usage: ./main.bin [--record FILE]
+//  --record  Write the input of every step to FILE at exit,
+//            for `./sim.bin --replay FILE` (see replay.h)
+int main(int argc, char **argv) {
 	// printf("Compiled on %s %s\n", __DATE__, __TIME__);
 	// printf("HELLO\n");
 	// printf("Number %.2d\n", 1);
 
 	struct world world;
+	world.record_path = NULL;
+
+	if (argc == 3 && strcmp(argv[1], "--record") == 0) {
+		world.record_path = argv[2];
+	}
+	else if (argc != 1) {
+		fprintf(stderr, "Usage: %s [--record FILE]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
 
 	sdlu_init(SDL_INIT_VIDEO);
 
@@ -290,9 +436,16 @@ int main(void) {
 	sdlu_fill_surface(world.surface, 27, 60, 20);
 	sdlu_update_window_surface(world.window);
 
-	srand(time(NULL));
+	game_textures_init(&world.textures, world.renderer);
+
+	game_init(&world.game);
 
-	game_init(&world.game, world.renderer);
+	const uint64_t seed = time(NULL);
+	game_seed(&world.game, seed);
+
+	if (world.record_path != NULL) {
+		replay_init(&world.replay, seed);
+	}
 
 	game_setup(&world.game);
 
@@ -300,29 +453,75 @@ int main(void) {
 
 	world.is_fullscreen = false;
 	world.quit = false;
+	world.ai_paddle = false;
 
-	uint64_t old_time = nsec_time();
-
-	while (!world.quit) {
-		const uint64_t new_time = nsec_time();
-		const uint64_t delta = new_time - old_time;
-		const double ddelta = (double)delta;
-		// printf("old_time: %ld new_time: %ld\n", old_time, new_time);
-		old_time = new_time;
+	SDL_DisplayMode display_mode;
 
-		// Reset game if dead or the level was cleared
+	if (SDL_GetWindowDisplayMode(world.window, &display_mode) == 0 &&
+	    display_mode.refresh_rate > 0)
+	{
+		world.frames_per_sec = display_mode.refresh_rate;
+	}
+	else {
+		world.frames_per_sec = 60.0;
+	}
 
-		const bool dead =
-			world.game.num_balls == 0 && world.game.num_particles == 0;
-		const bool level_cleared =
-			world.game.num_bricks == 0 && world.game.num_particles == 0;
+	world.paced = true;
+	pace_init(&world.pace, world.frames_per_sec);
+	frame_stats_start(&world.frame_stats);
+
+	SDL_GetMouseState(&world.mouse_x, NULL);
+	latency_init(&world.latency);
+
+	// Down to a quarter of the pixels
+	dynres_init(&world.dynres, 1000000000.0 / world.frames_per_sec, 0.5);
+	world.scene = NULL;
+	world.scene_w = 0;
+	world.scene_h = 0;
+
+	world.rects_len = 64;
+	world.rects = easy_malloc(world.rects_len * sizeof(SDL_Rect));
+	world.frects_len = 64;
+	world.frects = easy_malloc(world.frects_len * sizeof(SDL_FRect));
+	world.src_rects_len = 64;
+	world.src_rects = easy_malloc(world.src_rects_len * sizeof(SDL_Rect));
+	world.phases = easy_malloc(2 * world.src_rects_len * sizeof(game_scalar));
+
+	SDL_AtomicSet(&world.input.quit, 0);
+	SDL_AtomicSet(&world.input.ai_paddle, 0);
+	SDL_AtomicSet(&world.input.paddle_x, (int)world.game.paddle.pos_x);
+	SDL_AtomicSet(&world.input.paddle_sequence, 0);
+	SDL_AtomicSet(&world.input.num_speed_ups, 0);
+	SDL_AtomicSet(&world.input.num_speed_downs, 0);
+	SDL_AtomicSet(&world.input.num_resets, 0);
+	SDL_AtomicSet(&world.input.particle_collisions, 0);
+
+	// Publish the starting state so that there is always something to draw
+	snapshot_buffer_init(&world.snapshots);
+	snapshot_capture(snapshot_buffer_back(&world.snapshots), &world.game);
+	snapshot_buffer_publish(&world.snapshots);
+
+	SDL_Thread *const sim = SDL_CreateThread(sim_thread, "sim", &world);
+
+	if (sim == NULL) {
+		fprintf(stderr, "%s: SDL_CreateThread error: %s\n",
+			__func__, SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
 
-		if (dead || level_cleared) {
-			game_setup(&world.game);
+	while (!world.quit) {
+		if (world.paced) {
+			pace_wait(&world.pace);
 		}
 
-		// How much delta x movement the paddle did this frame
-		double paddle_dx = 0.0;
+		// Time spent on the frame itself, for `dynres`
+		const uint64_t frame_start = nsec_time();
+
+		// Input is read only after waiting, so that it is as new as it can be
+		//  when the sim thread picks it up
+		// Newest mouse x, and when the oldest motion not sent on yet happened
+		int mouse_x = world.mouse_x;
+		uint64_t mouse_time = 0;
 
 		SDL_Event event;
 		while (SDL_PollEvent(&event) != 0) { switch (event.type) {
@@ -362,38 +561,17 @@ int main(void) {
 			case SDL_MOUSEBUTTONDOWN:
 				// // For debugging
 				// printf("num_bricks: %d num_particles: %d\n",
-				// 	world.game.num_bricks, world.game.num_particles);
+				// 	world.game.num_bricks, world.game.particles.num);
 				break;
 			case SDL_MOUSEMOTION:
 			{
-				const double mouse_game_x = game_x_screen_to_coord(
-					event.motion.x,
-					world.game.viewport_center_x,
-					world.game.viewport_size_x,
-					world.surface->w);
+				mouse_x = event.motion.x;
 
-				double new_x = mouse_game_x
-					- (world.game.paddle.size_x / 2.0);
-
-				const double play_area_left = world.game.play_area_origin_x
-					- (world.game.play_area_size_x / 2.0);
-
-				const double play_area_right = world.game.play_area_origin_x
-					+ (world.game.play_area_size_x / 2.0);
-
-				const double paddle_max_right =
-					play_area_right - world.game.paddle.size_x;
-
-				if (new_x < play_area_left) {
-					new_x = play_area_left;
+				if (mouse_time == 0) {
+					// Event timestamps are in SDL_GetTicks milliseconds
+					const Uint32 age_ms = SDL_GetTicks() - event.motion.timestamp;
+					mouse_time = nsec_time() - (uint64_t)age_ms * 1000000llu;
 				}
-				else if (new_x > paddle_max_right) {
-					new_x = paddle_max_right;
-				}
-
-				paddle_dx = new_x - world.game.paddle.pos_x;
-
-				world.game.paddle.pos_x = new_x;
 
 				break;
 			}
@@ -404,33 +582,53 @@ int main(void) {
 				switch (keycode) {
 					case SDLK_w:
 					{
-						for (unsigned int i = 0; i < world.game.num_balls;
-						     i += 1)
-						{
-							struct ball *const ball = world.game.balls[i];
-
-							ball->vel_x *= 2.0;
-							ball->vel_y *= 2.0;
-						}
+						SDL_AtomicAdd(&world.input.num_speed_ups, 1);
 
 						break;
 					}
 					case SDLK_s:
 					{
-						for (unsigned int i = 0; i < world.game.num_balls;
-						     i += 1)
-						{
-							struct ball *const ball = world.game.balls[i];
-
-							ball->vel_x *= 0.5;
-							ball->vel_y *= 0.5;
-						}
+						SDL_AtomicAdd(&world.input.num_speed_downs, 1);
 
 						break;
 					}
 					case SDLK_r:
 					{
-						game_setup(&world.game);
+						SDL_AtomicAdd(&world.input.num_resets, 1);
+
+						break;
+					}
+					case SDLK_a:
+					{
+						world.ai_paddle = !world.ai_paddle;
+						SDL_AtomicSet(&world.input.ai_paddle, world.ai_paddle);
+
+						break;
+					}
+					case SDLK_c:
+					{
+						// Only this thread sets it
+						SDL_AtomicSet(&world.input.particle_collisions,
+							!SDL_AtomicGet(&world.input.particle_collisions));
+
+						break;
+					}
+					case SDLK_l:
+					{
+						frame_stats_print(&world.frame_stats, world.paced,
+							world.dynres.scale);
+						latency_print_summary(&world.latency, stdout);
+
+						break;
+					}
+					case SDLK_p:
+					{
+						frame_stats_print(&world.frame_stats, world.paced,
+							world.dynres.scale);
+
+						world.paced = !world.paced;
+						pace_init(&world.pace, world.frames_per_sec);
+						frame_stats_start(&world.frame_stats);
 
 						break;
 					}
@@ -494,433 +692,213 @@ int main(void) {
 			}
 		}}// End of 'while polling events' and 'switch on event type'
 
-		// Update particles
-		for (unsigned int i = 0; i < world.game.num_particles; i += 1) {
-			struct particle *const particle = world.game.particles[i];
-
-			particle->age_ns += delta;
-
-			if (particle->age_ns >= particle->lifetime_ns) {
-				game_remove_particle(&world.game, i);
-				i -= 1;
-				continue;
-			}
+		// The newest complete state of the game
+		const struct snapshot *const snap =
+			snapshot_buffer_acquire(&world.snapshots);
 
-			const double p_grav = 0.00000000000004;
+		// Only the newest mouse position matters
+		if (!world.ai_paddle && mouse_x != world.mouse_x) {
+			world.mouse_x = mouse_x;
 
-			// particle->vel_x *= 0.999;// Probably looks better without this
-			particle->vel_y -= p_grav * ddelta;
+			const double mouse_game_x = game_x_screen_to_coord(
+				mouse_x,
+				snap->viewport_center_x,
+				snap->viewport_size_x,
+				world.surface->w);
 
-			particle->pos_x += particle->vel_x * ddelta;
-			particle->pos_y += particle->vel_y * ddelta;
+			SDL_AtomicSet(&world.input.paddle_x,
+				(int)(mouse_game_x - (snap->paddle.size_x / 2.0)));
+			SDL_AtomicSet(&world.input.paddle_sequence,
+				latency_input(&world.latency, mouse_time));
 		}
 
-		// Update ball positions
-		for (unsigned int i = 0; i < world.game.num_balls; i += 1) {
-			struct ball *const ball = world.game.balls[i];
-
-			ball->pos_x += ball->vel_x * ddelta;
-			ball->pos_y += ball->vel_y * ddelta;
-
-			const double play_area_left = world.game.play_area_origin_x
-				- (world.game.play_area_size_x / 2.0);
-
-			const double play_area_right = world.game.play_area_origin_x
-				+ (world.game.play_area_size_x / 2.0);
-
-			const double play_area_top = world.game.play_area_origin_y
-				+ (world.game.play_area_size_y / 2.0);
-
-			const double play_area_bottom = world.game.play_area_origin_y
-				- (world.game.play_area_size_y / 2.0);
-
-			const double ball_right = ball->pos_x + ball->size_x;
-			const double ball_bottom = ball->pos_y - ball->size_y;
-
-			// Camera shake
-			const double bump_distance = 20.0;
-
-			// Bounce off the walls and ceiling
-			if (ball->pos_x < play_area_left) {
-				ball->pos_x = play_area_left;
-				ball->vel_x = -ball->vel_x;
-
-				world.game.viewport_center_x += bump_distance;
-			}
-
-			if (ball_right > play_area_right) {
-				ball->pos_x = play_area_right - ball->size_x;
-				ball->vel_x = -ball->vel_x;
-
-				world.game.viewport_center_x -= bump_distance;
-			}
-
-			if (ball->pos_y > play_area_top) {
-				ball->pos_y = play_area_top;
-				ball->vel_y = -ball->vel_y;
-
-				world.game.viewport_center_y -= bump_distance;
-			}
-
-			bool remove_ball = false;
-
-			if (ball_bottom < play_area_bottom) {
-				// Ball dies
-
-				remove_ball = true;
-
-				// Spawn particles
-				for (int p = 0; p < 400; p +=1 ) {
-					struct particle *particle = easy_malloc(
-						sizeof(struct particle));
-
-					rand_rect_inside_rect(
-						ball->pos_x, ball->pos_y,
-						ball->size_x, ball->size_y,
-						&particle->pos_x,
-						&particle->pos_y,
-						&particle->size_x,
-						&particle->size_y);
-
-					particle->vel_x = rand_double(-0.000008, 0.000008);
-					particle->vel_y = rand_double(0.000008, 0.000020);
-
-					particle->lifetime_ns = 3000000000;
-					particle->age_ns = 0;
-					particle->r = rand_int(0, 255);
-					particle->g = rand_int(0, 255);
-					particle->b = rand_int(0, 255);
-					particle->a = rand_int(0, 255);
-
-					game_append_particle(&world.game, particle);
-				}
-			}
-
-			// Check collision with paddle
-
-			enum collision coll = collide_rects(
-				world.game.paddle.pos_x,
-				world.game.paddle.pos_y,
-				world.game.paddle.size_x,
-				world.game.paddle.size_y,
-				ball->pos_x,
-				ball->pos_y,
-				ball->size_x,
-				ball->size_y);
-
-			if (coll != 0) {
-				// printf("coll: %d\n", coll);
-
-				// At 0.0 because is buggy and makes ball fly super fast
-				const double paddle_additive_speed_mult = 0.0;
-
-				const double diff_x = paddle_dx / ddelta
-					* paddle_additive_speed_mult;
-
-				// Maybe a switch should be used here
-
-				// If bouncing off the top
-				if (coll == COLL_TOP) {
-					ball->pos_y = world.game.paddle.pos_y + ball->size_y;
-
-					ball->vel_y = -ball->vel_y;
-					ball->vel_x += diff_x;
-				}
-
-				// diff_x should not be added if the ball and paddle
-				//  are moving in the same direction
-				//  at time of collision (is this correct? why?)
-				//  but close enough
+		// Render
 
-				// If hit left side
-				if (coll == COLL_LEFT) {
-					ball->pos_x = world.game.paddle.pos_x - ball->size_x;
+		// Pixels to draw the scene at this frame
+		const int scene_w = dynres_pixels(&world.dynres, world.surface->w);
+		const int scene_h = dynres_pixels(&world.dynres, world.surface->h);
 
-					ball->vel_x = -ball->vel_x + diff_x;
-				}
-				else if (coll == COLL_RIGHT) {
-					ball->pos_x = world.game.paddle.pos_x
-						+ world.game.paddle.size_x;
+		// At full scale, draw straight to the window
+		const bool offscreen = world.dynres.scale < 1.0;
 
-					ball->vel_x = -ball->vel_x + diff_x;
+		if (offscreen) {
+			if (world.scene == NULL ||
+			    scene_w != world.scene_w || scene_h != world.scene_h)
+			{
+				if (world.scene != NULL) {
+					SDL_DestroyTexture(world.scene);
 				}
-			}
-			else {
-				// No paddle collision
-				// Check if ball collides with a brick
-
-				for (unsigned int b = 0; b < world.game.num_bricks; b += 1) {
-					struct brick *const brick = world.game.bricks[b];
-
-					enum collision brick_coll = collide_rects(
-						brick->pos_x,
-						brick->pos_y,
-						brick->size_x,
-						brick->size_y,
-						ball->pos_x,
-						ball->pos_y,
-						ball->size_x,
-						ball->size_y);
-
-					switch (brick_coll) {
-						case COLL_TOP:
-							ball->pos_y = brick->pos_y + ball->size_y;
-							ball->vel_y = -ball->vel_y;
-							break;
-						case COLL_BOTTOM:
-							ball->pos_y = brick->pos_y - brick->size_y;
-							ball->vel_y = -ball->vel_y;
-							break;
-						case COLL_LEFT:
-							ball->pos_x = brick->pos_x - ball->size_x;
-							ball->vel_x = -ball->vel_x;
-							break;
-						case COLL_RIGHT:
-							ball->pos_x = brick->pos_x + brick->size_x;
-							ball->vel_x = -ball->vel_x;
-							break;
-						case COLL_NONE:
-							break;
-					}
-
-					if (brick_coll != COLL_NONE) {
-						// Spawn particles
-						for (int p = 0; p < 10; p +=1 ) {
-							struct particle *particle = easy_malloc(
-								sizeof(struct particle));
-
-							rand_rect_inside_rect(
-								brick->pos_x, brick->pos_y,
-								brick->size_x, brick->size_y,
-								&particle->pos_x,
-								&particle->pos_y,
-								&particle->size_x,
-								&particle->size_y);
-
-							double base_vx = ball->vel_x * 0.7;
-							double base_vy = ball->vel_y * 0.7;
-
-							// Invert because the ball already bounced
-							//  (velocity was mirrored previously)
-							if (brick_coll == COLL_LEFT ||
-							    brick_coll == COLL_RIGHT)
-							{
-								base_vx *= -1.0;
-							}
-							else {
-								base_vy *= -1.0;
-							}
-
-							particle->vel_x = base_vx
-								+ rand_double(-0.0000012, 0.0000012);
-							particle->vel_y = base_vy
-								+ rand_double(-0.0000008, 0.0000016);
-
-							particle->lifetime_ns = 3000000000;
-							particle->age_ns = 0;
-							particle->r = rand_int(0, 255);
-							particle->g = rand_int(0, 255);
-							particle->b = rand_int(0, 255);
-							particle->a = rand_int(0, 255);
-
-							game_append_particle(&world.game, particle);
-						}
-
-						// Remove brick
-						game_remove_brick(&world.game, b);
 
-						break;
-					}
-				}
+				world.scene = sdlu_create_texture(world.renderer,
+					world.surface->format->format,
+					SDL_TEXTUREACCESS_TARGET,
+					scene_w, scene_h);
+				world.scene_w = scene_w;
+				world.scene_h = scene_h;
 			}
 
-			if (remove_ball) {
-				game_remove_ball(&world.game, i);
-				i -= 1;
-			}
+			sdlu_set_render_target(world.renderer, world.scene);
 		}
 
-		// Camera shake with springs
-		const double accel_x = -world.game.camera_spring_constant
-			* (world.game.viewport_center_x - world.game.play_area_origin_x)
-			/ world.game.camera_mass;
-		const double accel_y = -world.game.camera_spring_constant
-			* (world.game.viewport_center_y - world.game.play_area_origin_y)
-			/ world.game.camera_mass;
-
-		world.game.camera_vel_x += accel_x;
-		world.game.camera_vel_y += accel_y;
-
-		world.game.viewport_center_x += world.game.camera_vel_x;
-		world.game.viewport_center_y += world.game.camera_vel_y;
-
-		world.game.camera_vel_x *= 0.95;
-		world.game.camera_vel_y *= 0.95;
-
-		// Render
-
 		// Fill screen with solid color
 		sdlu_set_render_draw_color(world.renderer, 27, 60, 20, 255);
 		sdlu_render_clear(world.renderer);
 
-		// Color the play area
-		const int pa_x = game_x_coord_to_screen(
-			world.game.play_area_origin_x - (world.game.play_area_size_x / 2.0),
-			world.game.viewport_center_x,
-			world.game.viewport_size_x,
-			world.surface->w);
-
-		const int pa_y = game_y_coord_to_screen(
-			world.game.play_area_origin_y + (world.game.play_area_size_y / 2.0),
-			world.game.viewport_center_y,
-			world.game.viewport_size_y,
-			world.surface->h);
-
-		const int pa_w = game_length_to_screen(world.game.play_area_size_x,
-			world.game.viewport_size_x, world.surface->w);
-		const int pa_h = game_length_to_screen(world.game.play_area_size_y,
-			world.game.viewport_size_y, world.surface->h);
+		// One transform for everything drawn this frame
+		struct game_viewport viewport;
+		game_viewport_compute_at(&viewport,
+			snap->viewport_center_x, snap->viewport_center_y,
+			snap->viewport_size_x, snap->viewport_size_y,
+			scene_w, scene_h);
 
+		// Color the play area
 		sdlu_set_render_draw_color(world.renderer, 55, 120, 40, 255);
-		SDL_Rect pa_rect = { .x = pa_x, .y = pa_y, .w = pa_w, .h = pa_h };
+		SDL_Rect pa_rect = game_viewport_rect(&viewport,
+			snap->play_area_origin_x - (snap->play_area_size_x / 2.0),
+			snap->play_area_origin_y + (snap->play_area_size_y / 2.0),
+			snap->play_area_size_x,
+			snap->play_area_size_y);
 		sdlu_render_fill_rect(world.renderer, &pa_rect);
 
 		// Render bricks
-		for (unsigned int i = 0; i < world.game.num_bricks; i += 1) {
-			struct brick *const brick = world.game.bricks[i];
+		world_reserve_rects(&world, snap->bricks.num);
+		game_viewport_rects(&viewport,
+			snap->bricks.pos_x, snap->bricks.pos_y,
+			snap->bricks.size_x, snap->bricks.size_y,
+			snap->bricks.num, world.rects);
 
-			// Move the brick's texture before rendering
-			brick->inner_tex_x_prop += brick->inner_tex_x_prop_speed * ddelta;
-			brick->inner_tex_y_prop += brick->inner_tex_y_prop_speed * ddelta;
+		// Thinner at lower resolutions so it looks the same when stretched
+		int border_thickness = 4.0 * world.dynres.scale + 0.5;
 
-			brick->inner_tex_x_prop = wrap_double01(brick->inner_tex_x_prop);
-			brick->inner_tex_y_prop = wrap_double01(brick->inner_tex_y_prop);
+		if (border_thickness < 1) {
+			border_thickness = 1;
+		}
 
-			const int x = game_x_coord_to_screen(
-				brick->pos_x,
-				world.game.viewport_center_x,
-				world.game.viewport_size_x,
-				world.surface->w);
+		// Scroll every brick's texture at once, so the loop below only draws
+		world_reserve_src_rects(&world, snap->bricks.num);
+		snapshot_brick_src_rects(snap, &world.textures,
+			world.phases, world.src_rects);
 
-			const int y = game_y_coord_to_screen(
-				brick->pos_y,
-				world.game.viewport_center_y,
-				world.game.viewport_size_y,
-				world.surface->h);
+		// Solid color border/background
+		sdlu_set_render_draw_color(world.renderer, 255, 255, 0, 255);
 
-			const int w = game_length_to_screen(
-				brick->size_x, world.game.viewport_size_x, world.surface->w);
-			const int h = game_length_to_screen(
-				brick->size_y, world.game.viewport_size_y, world.surface->h);
+		for (unsigned int i = 0; i < snap->bricks.num; i += 1) {
+			const SDL_Rect bg_rect = world.rects[i];
 
-			// Solid color border/background
-			sdlu_set_render_draw_color(world.renderer, 255, 255, 0, 255);
-			SDL_Rect bg_rect = { .x = x, .y = y, .w = w, .h = h };
 			sdlu_render_fill_rect(world.renderer, &bg_rect);
 
-			const int border_thickness = 4;
 			SDL_Rect inner_rect = {
-				.x = x + border_thickness,
-				.y = y + border_thickness,
-				.w = w - 2 * border_thickness,
-				.h = h - 2 * border_thickness
+				.x = bg_rect.x + border_thickness,
+				.y = bg_rect.y + border_thickness,
+				.w = bg_rect.w - 2 * border_thickness,
+				.h = bg_rect.h - 2 * border_thickness
 			};
 
-			uint32_t format;
-			int access;
-			int tex_w;
-			int tex_h;
+			// Draw from the mip level closest to the size on screen
+			const unsigned int tex = snap->brick_tex_indices[i];
+			const unsigned int level = mip_level(world.src_rects[i].w,
+				inner_rect.w, world.textures.brick_num_mips[tex]);
+			const SDL_Rect src_rect = mip_rect(world.src_rects[i], level);
 
-			sdlu_query_texture(brick->inner_tex,
-				&format, &access, &tex_w, &tex_h);
-
-			const int tex_x = brick->inner_tex_x_prop
-				* (tex_w - brick->inner_tex_w);
-			const int tex_y = brick->inner_tex_y_prop
-				* (tex_h - brick->inner_tex_h);
-
-			SDL_Rect srcrect = {
-				.x = tex_x,
-				.y = tex_y,
-				.w = brick->inner_tex_w,
-				.h = brick->inner_tex_h};
-
-			sdlu_render_copy(
-				world.renderer, brick->inner_tex, &srcrect, &inner_rect);
+			sdlu_render_copy(world.renderer,
+				world.textures.brick_mips[tex][level],
+				&src_rect, &inner_rect);
 		}
 
 		// Render balls
-		for (unsigned int i = 0; i < world.game.num_balls; i += 1) {
-			const struct ball *const ball = world.game.balls[i];
-
-			const int x = game_x_coord_to_screen(
-				ball->pos_x,
-				world.game.viewport_center_x,
-				world.game.viewport_size_x,
-				world.surface->w);
-
-			const int y = game_y_coord_to_screen(
-				ball->pos_y,
-				world.game.viewport_center_y,
-				world.game.viewport_size_y,
-				world.surface->h);
-
-			// printf("ball (x, y): (%d, %d)\n", x, y);
-
-			const int w = game_length_to_screen(
-				ball->size_x, world.game.viewport_size_x, world.surface->w);
-			const int h = game_length_to_screen(
-				ball->size_y, world.game.viewport_size_y, world.surface->h);
-
-			// printf("(w, h): (%d, %d)\n", w, h);
-
-			SDL_Rect rect = { .x = x, .y = y, .w = w, .h = h };
-
-			sdlu_render_copy(world.renderer, ball->tex, NULL, &rect);
+		world_reserve_rects(&world, snap->balls.num);
+		game_viewport_rects(&viewport,
+			snap->balls.pos_x, snap->balls.pos_y,
+			snap->balls.size_x, snap->balls.size_y,
+			snap->balls.num, world.rects);
+
+		for (unsigned int i = 0; i < snap->balls.num; i += 1) {
+			sdlu_render_copy(world.renderer,
+				world.textures.ball, NULL, &world.rects[i]);
 		}
 
 		// Render paddle
 		{
-			const int x = game_x_coord_to_screen(
-				world.game.paddle.pos_x,
-				world.game.viewport_center_x,
-				world.game.viewport_size_x,
-				world.surface->w);
-
-			const int y = game_y_coord_to_screen(
-				world.game.paddle.pos_y,
-				world.game.viewport_center_y,
-				world.game.viewport_size_y,
-				world.surface->h);
-
-			int w = game_length_to_screen(world.game.paddle.size_x,
-				world.game.viewport_size_x, world.surface->w);
-			int h = game_length_to_screen(world.game.paddle.size_y,
-				world.game.viewport_size_y, world.surface->h);
-
 			sdlu_set_render_draw_color(world.renderer, 255, 255, 255, 255);
-			SDL_Rect rect = { .x = x, .y = y, .w = w, .h = h };
+			SDL_Rect rect = game_viewport_rect(&viewport,
+				snap->paddle.pos_x,
+				snap->paddle.pos_y,
+				snap->paddle.size_x,
+				snap->paddle.size_y);
 			sdlu_render_fill_rect(world.renderer, &rect);
 		}
 
 		// Render particles
-		for (unsigned int i = 0; i < world.game.num_particles; i += 1) {
-			game_render_particle(
-				&world.game,
-				world.game.particles[i],
-				world.surface->w,
-				world.surface->h,
-				world.renderer);
+		world_reserve_frects(&world, snap->particles.num);
+		game_viewport_frects(&viewport,
+			snap->particles.pos_x, snap->particles.pos_y,
+			snap->particles.size_x, snap->particles.size_y,
+			snap->particles.num, world.frects);
+
+		for (unsigned int i = 0; i < snap->particles.num; i += 1) {
+			const SDL_Color color = snap->particle_colors[i];
+
+			sdlu_set_render_draw_color(world.renderer,
+				color.r, color.g, color.b, color.a);
+			sdlu_render_fill_frect(world.renderer, &world.frects[i]);
+		}
+
+		if (offscreen) {
+			// Stretch the scene over the whole window
+			sdlu_set_render_target(world.renderer, NULL);
+			sdlu_render_copy(world.renderer, world.scene, NULL, NULL);
 		}
 
 		// Update screen
 		SDL_RenderPresent(world.renderer);
+
+		const uint64_t present_time = nsec_time();
+
+		latency_present(&world.latency,
+			snap->input_sequence, snap->time, present_time);
+
+		dynres_update(&world.dynres, present_time - frame_start);
+
+		world.frame_stats.num_frames += 1;
+	}
+
+	frame_stats_print(&world.frame_stats, world.paced, world.dynres.scale);
+	latency_print(&world.latency, stdout);
+
+	SDL_AtomicSet(&world.input.quit, 1);
+	SDL_WaitThread(sim, NULL);
+
+	if (world.record_path != NULL) {
+		world.replay.end_hash = replay_hash(&world.game);
+		replay_write(&world.replay, world.record_path);
+
+		printf("Recorded %u steps to %s\n",
+			world.replay.num_steps, world.record_path);
+
+		replay_deinit(&world.replay);
 	}
 
 	SDL_DestroyWindow(world.window);
 
 	game_desetup(&world.game);
 	game_deinit(&world.game);
+	game_textures_deinit(&world.textures);
+
+	snapshot_buffer_deinit(&world.snapshots);
+
+	if (world.scene != NULL) {
+		SDL_DestroyTexture(world.scene);
+	}
+
+	easy_free(world.rects);
+	easy_free(world.frects);
+	easy_free(world.src_rects);
+	easy_free(world.phases);
+
+	// Whatever is left was leaked
+	if (EASY_ALLOC_TRACKING) {
+		easy_alloc_print_report(stdout);
+	}
 
 	IMG_Quit();
 
@@ -0,0 +1,495 @@
+// Performance regression check
+// Runs a fixed set of seeded headless scenarios several times each and
+//  compares ns per step, overall and per phase (see phases.h), to a
+//  baseline file. Exits with 1 if any is slower by more than both
+//  PERF_MIN_SLOWDOWN and the run to run noise.
+//
+// Usage: ./perfcheck.bin BASELINE
+//        ./perfcheck.bin --write BASELINE
+//        ./perfcheck.bin --other-flags BASELINE
+//  --write        Measure and write a new baseline instead of comparing
+//  --other-flags  Compare even if the baseline's flags differ from this
+//                 build's, to see what the flags change (`make pgoreport`)
+//
+// The scenarios are deterministic: if a scenario's game results differ
+//  from the baseline's, the game itself changed, timings can not be
+//  compared, and the baseline has to be written again.
+// Timings only compare between builds with the same compiler and flags
+//  on the same machine. The baseline records both, and a build with a
+//  different compiler or flags skips the comparison without timing
+//  anything. Only a slowdown fails.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "nsec.h"
+#include "phases.h"
+
+// Times each scenario is run. The median is compared
+#define PERF_REPS 7
+
+// Slower by less than this share is never a regression
+#define PERF_MIN_SLOWDOWN 0.05
+// Nor by less than this many combined standard deviations of the runs
+#define PERF_NOISE_SIGMAS 4.0
+// Nor by less than this many ns per step (timer resolution)
+#define PERF_MIN_NS 2.0
+
+// The whole step, then each phase
+#define PERF_NUM_METRICS (1 + NUM_PHASES)
+
+#define PERF_MAX_LINE 256
+
+// Compiler flags of this build, set by the makefile
+#ifndef PERF_FLAGS
+#define PERF_FLAGS "unknown"
+#endif
+
+struct perf_scenario {
+	const char *name;
+	uint64_t seed;
+	uint64_t step_ns;
+	unsigned int num_steps;
+	double play_area_size_x;
+	double play_area_size_y;
+};
+
+static const struct perf_scenario perf_scenarios[] = {
+	// The default level
+	{"level", 1, 16667000, 20000, 3000.0, 4000.0},
+	// Long steps: the ball dies often, so there are many particle bursts
+	{"deaths", 2, 60000000, 20000, 3000.0, 4000.0},
+	// About 4000 bricks for the broadphase and contacts
+	{"big_level", 3, 16667000, 5000, 30000.0, 40000.0}
+};
+
+#define PERF_NUM_SCENARIOS \
+	(sizeof(perf_scenarios) / sizeof(perf_scenarios[0]))
+
+// The game's outcome, which must not depend on timing
+struct perf_result {
+	uint64_t bricks_cleared;
+	uint64_t ball_deaths;
+};
+
+// Median and spread of one metric over the reps
+struct perf_metric {
+	double median;
+	double spread;// Standard deviation estimated from the median deviation
+};
+
+struct perf_measurement {
+	struct perf_result result;
+	struct perf_metric metrics[PERF_NUM_METRICS];
+};
+
+static const char *metric_name(const unsigned int metric) {
+	return (metric == 0) ? "step" : phase_names[metric - 1];
+}
+
+static int compare_doubles(const void *const a, const void *const b) {
+	const double x = *(const double*)a;
+	const double y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+// Sorts `values`
+static double median(double *const values, const unsigned int num) {
+	qsort(values, num, sizeof(double), compare_doubles);
+
+	return (num % 2 == 1)
+		? values[num / 2]
+		: (values[num / 2 - 1] + values[num / 2]) / 2.0;
+}
+
+static struct perf_metric summarize(double *const values) {
+	const double mid = median(values, PERF_REPS);
+
+	double deviations[PERF_REPS];
+	for (unsigned int i = 0; i < PERF_REPS; i += 1) {
+		deviations[i] = fabs(values[i] - mid);
+	}
+
+	// 1.4826 makes the median absolute deviation estimate the standard
+	//  deviation of normal noise, without being thrown by outliers
+	return (struct perf_metric) {
+		.median = mid,
+		.spread = 1.4826 * median(deviations, PERF_REPS)
+	};
+}
+
+// Play one scenario once. Writes ns per step for each metric to `out`
+static struct perf_result run_once(
+	const struct perf_scenario *const scenario,
+	double out[PERF_NUM_METRICS])
+{
+	struct game game;
+	game_init(&game);
+	game_seed(&game, scenario->seed);
+
+	// OpenMP threads would only add noise
+	game.parallel = false;
+	game.play_area_size_x = scenario->play_area_size_x;
+	game.play_area_size_y = scenario->play_area_size_y;
+
+	game_setup(&game);
+
+	struct perf_result result = {0};
+	uint64_t phase_ticks[NUM_PHASES] = {0};
+	uint64_t step_ns = 0;
+
+	for (unsigned int i = 0; i < scenario->num_steps; i += 1) {
+		// Same rule as the windowed game. Setup is not timed
+		if ((game.num_balls == 0 || game.num_bricks == 0)
+			&& game.particles.num == 0)
+		{
+			game_setup(&game);
+		}
+
+		const unsigned int num_balls = game.num_balls;
+		const unsigned int num_bricks = game.num_bricks;
+
+		const uint64_t start = nsec_time();
+		phases_step(&game, scenario->step_ns, NULL, phase_ticks);
+		step_ns += nsec_time() - start;
+
+		result.ball_deaths += num_balls - game.num_balls;
+		result.bricks_cleared += num_bricks - game.num_bricks;
+	}
+
+	game_desetup(&game);
+	game_deinit(&game);
+
+	out[0] = (double)step_ns / scenario->num_steps;
+
+	for (unsigned int i = 0; i < NUM_PHASES; i += 1) {
+		out[1 + i] =
+			(double)nsec_ticks_to_ns(phase_ticks[i]) / scenario->num_steps;
+	}
+
+	return result;
+}
+
+static struct perf_measurement measure(
+	const struct perf_scenario *const scenario)
+{
+	double samples[PERF_NUM_METRICS][PERF_REPS];
+	struct perf_measurement measurement;
+
+	// One untimed run to warm up caches and the branch predictor
+	double warmup[PERF_NUM_METRICS];
+	measurement.result = run_once(scenario, warmup);
+
+	for (unsigned int rep = 0; rep < PERF_REPS; rep += 1) {
+		double values[PERF_NUM_METRICS];
+		const struct perf_result result = run_once(scenario, values);
+
+		if (result.bricks_cleared != measurement.result.bricks_cleared
+			|| result.ball_deaths != measurement.result.ball_deaths)
+		{
+			fprintf(stderr, "%s: scenario %s played out differently "
+				"between runs\n", __func__, scenario->name);
+			exit(EXIT_FAILURE);
+		}
+
+		for (unsigned int m = 0; m < PERF_NUM_METRICS; m += 1) {
+			samples[m][rep] = values[m];
+		}
+	}
+
+	for (unsigned int m = 0; m < PERF_NUM_METRICS; m += 1) {
+		measurement.metrics[m] = summarize(samples[m]);
+	}
+
+	return measurement;
+}
+
+static void write_baseline(
+	const char *const path,
+	const struct perf_measurement *const measurements)
+{
+	FILE *const file = fopen(path, "w");
+
+	if (file == NULL) {
+		fprintf(stderr, "%s: Failed to open %s for writing\n", __func__, path);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(file, "# perfcheck baseline. Write a new one with "
+		"`make perfbaseline`\n");
+	fprintf(file, "# metric SCENARIO NAME MEDIAN_NS_PER_STEP SPREAD_NS\n");
+	fprintf(file, "compiler %s\n", __VERSION__);
+	fprintf(file, "flags %s\n", PERF_FLAGS);
+
+	for (unsigned int s = 0; s < PERF_NUM_SCENARIOS; s += 1) {
+		const struct perf_measurement *const measurement = &measurements[s];
+
+		fprintf(file, "result %s %lu %lu\n",
+			perf_scenarios[s].name,
+			(unsigned long)measurement->result.bricks_cleared,
+			(unsigned long)measurement->result.ball_deaths);
+
+		for (unsigned int m = 0; m < PERF_NUM_METRICS; m += 1) {
+			fprintf(file, "metric %s %s %.2f %.2f\n",
+				perf_scenarios[s].name,
+				metric_name(m),
+				measurement->metrics[m].median,
+				measurement->metrics[m].spread);
+		}
+	}
+
+	fclose(file);
+}
+
+static unsigned int scenario_index(const char *const name) {
+	for (unsigned int s = 0; s < PERF_NUM_SCENARIOS; s += 1) {
+		if (strcmp(perf_scenarios[s].name, name) == 0) {
+			return s;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+static unsigned int metric_index(const char *const name) {
+	for (unsigned int m = 0; m < PERF_NUM_METRICS; m += 1) {
+		if (strcmp(metric_name(m), name) == 0) {
+			return m;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+// If the file is missing or has a bad line, prints to stderr and exits
+// Lines for unknown scenarios or metrics are skipped, so that old
+//  baselines still work after some are added or removed
+static void read_baseline(
+	const char *const path,
+	struct perf_measurement *const measurements,
+	bool has_metric[PERF_NUM_SCENARIOS][PERF_NUM_METRICS],
+	bool *const same_compiler,
+	bool *const same_flags)
+{
+	FILE *const file = fopen(path, "r");
+
+	if (file == NULL) {
+		fprintf(stderr, "%s: Failed to open %s. "
+			"Write one with `make perfbaseline`\n", __func__, path);
+		exit(EXIT_FAILURE);
+	}
+
+	// A baseline without these lines was written by an unknown build
+	*same_compiler = false;
+	*same_flags = false;
+
+	char line[PERF_MAX_LINE];
+	unsigned int line_number = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		line_number += 1;
+		line[strcspn(line, "\n")] = '\0';
+
+		char scenario[64];
+		char metric[64];
+		unsigned long bricks_cleared;
+		unsigned long ball_deaths;
+		double median;
+		double spread;
+
+		if (line[0] == '#' || line[0] == '\0') {
+			continue;
+		}
+		else if (strncmp(line, "compiler ", 9) == 0) {
+			*same_compiler = strcmp(line + 9, __VERSION__) == 0;
+		}
+		else if (strncmp(line, "flags ", 6) == 0) {
+			*same_flags = strcmp(line + 6, PERF_FLAGS) == 0;
+		}
+		else if (sscanf(line, "result %63s %lu %lu",
+			scenario, &bricks_cleared, &ball_deaths) == 3)
+		{
+			const unsigned int s = scenario_index(scenario);
+
+			if (s != UINT32_MAX) {
+				measurements[s].result.bricks_cleared = bricks_cleared;
+				measurements[s].result.ball_deaths = ball_deaths;
+			}
+		}
+		else if (sscanf(line, "metric %63s %63s %lf %lf",
+			scenario, metric, &median, &spread) == 4)
+		{
+			const unsigned int s = scenario_index(scenario);
+			const unsigned int m = metric_index(metric);
+
+			if (s != UINT32_MAX && m != UINT32_MAX) {
+				measurements[s].metrics[m] = (struct perf_metric) {
+					.median = median,
+					.spread = spread
+				};
+				has_metric[s][m] = true;
+			}
+		}
+		else {
+			fprintf(stderr, "%s: %s:%u: Can not read: %s\n",
+				__func__, path, line_number, line);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	fclose(file);
+}
+
+// Prints a line for the metric. Returns true if it got significantly slower
+static bool compare_metric(
+	const char *const scenario,
+	const char *const name,
+	const struct perf_metric *const base,
+	const struct perf_metric *const now)
+{
+	const double slowdown = now->median - base->median;
+	const double noise = sqrt(base->spread * base->spread
+		+ now->spread * now->spread);
+
+	const bool slower = slowdown > PERF_MIN_SLOWDOWN * base->median
+		&& slowdown > PERF_NOISE_SIGMAS * noise
+		&& slowdown > PERF_MIN_NS;
+
+	printf("%-10s %-10s %10.1f %10.1f %+7.1f%% %8.1f  %s\n",
+		scenario,
+		name,
+		base->median,
+		now->median,
+		base->median > 0.0 ? 100.0 * slowdown / base->median : 0.0,
+		noise,
+		slower ? "SLOWER" : "ok");
+
+	return slower;
+}
+
+int main(int argc, char **argv) {
+	bool write = false;
+	bool other_flags = false;
+	const char *path = NULL;
+
+	if (argc == 2) {
+		path = argv[1];
+	}
+	else if (argc == 3 && strcmp(argv[1], "--write") == 0) {
+		write = true;
+		path = argv[2];
+	}
+	else if (argc == 3 && strcmp(argv[1], "--other-flags") == 0) {
+		other_flags = true;
+		path = argv[2];
+	}
+	else {
+		fprintf(stderr, "Usage: %s [--write | --other-flags] BASELINE\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	struct perf_measurement baseline[PERF_NUM_SCENARIOS];
+	bool has_metric[PERF_NUM_SCENARIOS][PERF_NUM_METRICS];
+
+	// Check that the timings can compare before taking them
+	if (!write) {
+		bool same_compiler;
+		bool same_flags;
+
+		memset(baseline, 0, sizeof(baseline));
+		memset(has_metric, 0, sizeof(has_metric));
+		read_baseline(path, baseline, has_metric,
+			&same_compiler, &same_flags);
+
+		if (!same_compiler || (!same_flags && !other_flags)) {
+			printf("SKIPPED: %s was written by a build with %s, "
+				"so its timings do not compare. "
+				"This build is %s with flags: %s\n"
+				"Write a baseline for this build with `make perfbaseline`\n",
+				path,
+				same_compiler ? "other flags" : "a different compiler",
+				__VERSION__,
+				PERF_FLAGS);
+			return EXIT_SUCCESS;
+		}
+	}
+
+	nsec_calibrate();
+
+	struct perf_measurement measurements[PERF_NUM_SCENARIOS];
+
+	for (unsigned int s = 0; s < PERF_NUM_SCENARIOS; s += 1) {
+		measurements[s] = measure(&perf_scenarios[s]);
+	}
+
+	if (write) {
+		write_baseline(path, measurements);
+		printf("Wrote %s\n", path);
+
+		return EXIT_SUCCESS;
+	}
+
+	printf("%-10s %-10s %10s %10s %8s %8s\n",
+		"scenario", "ns/step", "baseline", "now", "change", "noise");
+
+	unsigned int num_slower = 0;
+	unsigned int num_changed = 0;
+
+	for (unsigned int s = 0; s < PERF_NUM_SCENARIOS; s += 1) {
+		const struct perf_result *const base = &baseline[s].result;
+		const struct perf_result *const now = &measurements[s].result;
+
+		if (!has_metric[s][0]) {
+			printf("%-10s not in baseline\n", perf_scenarios[s].name);
+			continue;
+		}
+
+		if (base->bricks_cleared != now->bricks_cleared
+			|| base->ball_deaths != now->ball_deaths)
+		{
+			printf("%-10s played out differently: %lu bricks and %lu deaths, "
+				"baseline %lu and %lu\n",
+				perf_scenarios[s].name,
+				(unsigned long)now->bricks_cleared,
+				(unsigned long)now->ball_deaths,
+				(unsigned long)base->bricks_cleared,
+				(unsigned long)base->ball_deaths);
+			num_changed += 1;
+			continue;
+		}
+
+		for (unsigned int m = 0; m < PERF_NUM_METRICS; m += 1) {
+			if (!has_metric[s][m]) {
+				printf("%-10s %-10s not in baseline\n",
+					perf_scenarios[s].name, metric_name(m));
+				continue;
+			}
+
+			num_slower += compare_metric(perf_scenarios[s].name,
+				metric_name(m), &baseline[s].metrics[m],
+				&measurements[s].metrics[m]);
+		}
+	}
+
+	if (num_changed > 0) {
+		printf("FAIL: %u scenarios no longer match the baseline's games. "
+			"If that is intended, run `make perfbaseline`\n", num_changed);
+		return EXIT_FAILURE;
+	}
+
+	if (num_slower > 0) {
+		printf("FAIL: %u timings are slower than the baseline\n", num_slower);
+		return EXIT_FAILURE;
+	}
+
+	printf("OK\n");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,285 @@
+// Writes the session that `make pgo` trains on by default
+//  (pgo/session.replay, see `make session`)
+// Nobody can play the windowed game where this is built, so instead of
+//  `./main.bin --record FILE` this plays a scripted player through the
+//  same input path as main's sim thread and records it the same way:
+//  - Steps of about 1.1 ms, as main's sim thread takes with its
+//    `SDL_Delay(1)`, with now and then a longer one from the scheduler
+//  - The mouse is read once per 60 Hz frame, moved to whole pixels of a
+//    1280 pixel wide window, and only recorded when it moves
+//  - The player aims the middle of the paddle at where `predict_catch`
+//    said the ball would land a reaction time ago, with a hand that has
+//    a top speed, and a miss of up to half of the paddle per aim.
+//    Fast balls get away
+//  - Presses speed up and speed down now and then, resets once, and
+//    lets the attract mode play for a while once
+// Plays until SESSION_LEVELS levels are cleared
+//
+// Usage: ./session.bin FILE
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "predict.h"
+#include "rand.h"
+#include "replay.h"
+
+#define SESSION_SEED 1792356678
+// Drives the player's choices, not the game
+#define SESSION_PLAYER_SEED 7
+
+#define SESSION_LEVELS 3
+// Gives up if the levels are not cleared by then
+#define SESSION_MAX_NS 600000000000llu
+
+#define SESSION_SCREEN_W 1280
+#define SESSION_FRAME_NS 16666667
+
+// How long before the player reacts to where the ball is going
+#define SESSION_REACTION_NS 220000000
+// Units/ns the hand moves the paddle at most. Across the play area
+//  in about a quarter of a second
+#define SESSION_HAND_SPEED 0.000012
+// Share of the way to the aim the hand covers each frame
+#define SESSION_HAND_EASE 0.35
+
+// Frames of aims kept for the reaction time
+#define SESSION_AIMS 64
+
+// Length of the longest step (see SIM_MAX_DELTA_NS in main/main.c)
+#define SESSION_MAX_DELTA_NS 50000000
+
+struct session_player {
+	struct rand_state rand;
+
+	// Where the player wanted the middle of the paddle, each frame
+	double aims[SESSION_AIMS];
+	unsigned int num_frames;
+
+	double miss;// Added to the current aim
+	double hand_x;// Where the mouse puts the middle of the paddle
+	int mouse_x;// Pixel
+
+	bool ai_paddle;
+	uint64_t ai_until_ns;
+	bool did_ai;
+	bool did_reset;
+
+	uint64_t level_start_ns;
+	bool pressed_speed;
+};
+
+static uint64_t next_delta(struct session_player *const player) {
+	// Sleeping 1 ms, then the step itself
+	double delta = 1060000.0
+		- 60000.0 * log(1.0 - rand_state_double01(&player->rand));
+
+	// Another thread had the core
+	if (rand_state_double01(&player->rand) < 0.004) {
+		delta += rand_state_double(&player->rand, 2000000.0, 12000000.0);
+	}
+
+	return delta > SESSION_MAX_DELTA_NS ? SESSION_MAX_DELTA_NS : delta;
+}
+
+// Once per frame: what the player sees, wants, and does with the mouse
+// Fills in the keys pressed this frame
+static void player_frame(
+	struct session_player *const player,
+	const struct game *const game,
+	const uint64_t time,
+	struct replay_step *const keys)
+{
+	// Where the middle of the paddle should go for the ball seen now
+	double aim = player->aims[(player->num_frames + SESSION_AIMS - 1)
+		% SESSION_AIMS];
+	double paddle_x;
+	double catch_time = HUGE_VAL;
+
+	if (predict_catch(game, &paddle_x, &catch_time)) {
+		aim = paddle_x + game->paddle.size_x / 2.0;
+	}
+
+	player->aims[player->num_frames % SESSION_AIMS] = aim;
+	player->num_frames += 1;
+
+	// Reacting to what was seen a while ago
+	const unsigned int reaction_frames =
+		SESSION_REACTION_NS / SESSION_FRAME_NS;
+	const unsigned int seen = player->num_frames > reaction_frames
+		? player->num_frames - 1 - reaction_frames
+		: 0;
+	const double seen_aim = player->aims[seen % SESSION_AIMS];
+
+	// A new miss whenever the aim jumps, as after a bounce
+	if (fabs(seen_aim - player->hand_x) > game->paddle.size_x) {
+		player->miss = rand_state_double(&player->rand, -0.5, 0.5)
+			* game->paddle.size_x;
+	}
+
+	const double target = seen_aim + player->miss;
+	const double max_move = SESSION_HAND_SPEED * SESSION_FRAME_NS;
+
+	double move = (target - player->hand_x) * SESSION_HAND_EASE;
+	if (move > max_move) {
+		move = max_move;
+	}
+	else if (move < -max_move) {
+		move = -max_move;
+	}
+
+	player->hand_x += move + rand_state_double(&player->rand, -4.0, 4.0);
+
+	player->mouse_x = game_x_coord_to_screen(player->hand_x,
+		game->viewport_center_x, game->viewport_size_x, SESSION_SCREEN_W);
+
+	if (player->mouse_x < 0) {
+		player->mouse_x = 0;
+	}
+	else if (player->mouse_x >= SESSION_SCREEN_W) {
+		player->mouse_x = SESSION_SCREEN_W - 1;
+	}
+
+	// Keys
+
+	const uint64_t level_ns = time - player->level_start_ns;
+
+	// Speed the ball up once it is going, and back down if it gets away
+	if (!player->pressed_speed && level_ns > 4000000000llu
+		&& rand_state_double01(&player->rand) < 0.01)
+	{
+		keys->num_speed_ups = 1;
+		player->pressed_speed = true;
+	}
+
+	if (game->num_balls > 0 && catch_time < 200000000.0
+		&& fabs(player->hand_x - aim) > game->paddle.size_x
+		&& rand_state_double01(&player->rand) < 0.05)
+	{
+		keys->num_speed_downs = 1;
+	}
+
+	// Start over once, early on
+	if (!player->did_reset && time > 9000000000llu) {
+		keys->reset = true;
+		player->did_reset = true;
+	}
+
+	// Watch the attract mode for a bit, once
+	if (!player->did_ai && time > 40000000000llu) {
+		player->ai_paddle = true;
+		player->ai_until_ns = time + 6000000000llu;
+		player->did_ai = true;
+	}
+
+	if (player->ai_paddle && time > player->ai_until_ns) {
+		player->ai_paddle = false;
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	struct game game;
+	game_init(&game);
+	game_seed(&game, SESSION_SEED);
+	game_setup(&game);
+
+	struct replay replay;
+	replay_init(&replay, SESSION_SEED);
+
+	struct session_player player = {
+		.hand_x = game.paddle.pos_x + game.paddle.size_x / 2.0
+	};
+	rand_state_seed(&player.rand, SESSION_PLAYER_SEED);
+
+	for (unsigned int i = 0; i < SESSION_AIMS; i += 1) {
+		player.aims[i] = player.hand_x;
+	}
+
+	// Same as main's sim thread
+	int paddle_x = INT_MIN;
+
+	unsigned int levels_cleared = 0;
+	uint64_t time = 0;
+	uint64_t next_frame_ns = 0;
+
+	// Keys pressed in the last frame, applied on the next step
+	struct replay_step keys = {0};
+
+	while (levels_cleared < SESSION_LEVELS && time < SESSION_MAX_NS) {
+		const uint64_t delta = next_delta(&player);
+
+		const bool dead = game.num_balls == 0 && game.particles.num == 0;
+		const bool level_cleared =
+			game.num_bricks == 0 && game.particles.num == 0;
+
+		if (level_cleared) {
+			levels_cleared += 1;
+		}
+
+		if (dead || level_cleared) {
+			game_setup(&game);
+			player.level_start_ns = time;
+			player.pressed_speed = false;
+		}
+
+		if (time >= next_frame_ns) {
+			player_frame(&player, &game, time, &keys);
+			next_frame_ns += SESSION_FRAME_NS;
+		}
+
+		struct replay_step step = {
+			.delta = delta,
+			.paddle_x = REPLAY_NO_PADDLE,
+			.ai_paddle = player.ai_paddle,
+			.reset = keys.reset,
+			.num_speed_ups = keys.num_speed_ups,
+			.num_speed_downs = keys.num_speed_downs
+		};
+
+		keys = (struct replay_step) {0};
+
+		if (!step.ai_paddle) {
+			const int new_paddle_x = game_x_screen_to_coord(player.mouse_x,
+				game.viewport_center_x, game.viewport_size_x, SESSION_SCREEN_W)
+				- game.paddle.size_x / 2.0;
+
+			if (new_paddle_x != paddle_x) {
+				paddle_x = new_paddle_x;
+				step.paddle_x = paddle_x;
+			}
+		}
+		else {
+			// The hand rests where the attract mode leaves the paddle
+			player.hand_x = game.paddle.pos_x + game.paddle.size_x / 2.0;
+		}
+
+		const double paddle_dx = replay_apply(&game, &step);
+		replay_append(&replay, &step);
+
+		game_step(&game, delta, paddle_dx);
+
+		time += delta;
+	}
+
+	replay.end_hash = replay_hash(&game);
+	replay_write(&replay, argv[1]);
+
+	printf("Wrote %u steps, %.1f s, %u levels to %s\n",
+		replay.num_steps, time / 1000000000.0, levels_cleared, argv[1]);
+
+	replay_deinit(&replay);
+	game_desetup(&game);
+	game_deinit(&game);
+
+	return levels_cleared < SESSION_LEVELS ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,485 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "easy_alloc.h"
+#include "evsim.h"
+#include "game.h"
+#include "nsec.h"
+#include "phases.h"
+#include "pool.h"
+#include "replay.h"
+
+// Runs games with no window and prints statistics as JSON
+// The paddle is moved by the controller in predict.h
+//
+// Usage: ./sim.bin [--games N] [--threads T] [--seconds S] [--step-us U]
+//  [--seed N] [--evsim] [--alloc-check W] [--replay FILE]
+//  [--particle-collisions]
+//  --games    Number of independent games (default 1)
+//  --threads  Threads to run the games on, 0 for all cores (default 1)
+//  --seconds  Simulated seconds per game (default 600)
+//  --step-us  Fixed frame step in microseconds (default 16667)
+//  --seed     Game `i` is seeded with `seed + i` (default 1)
+//  --evsim    Use the event-driven engine (evsim.h) instead of fixed steps
+//  --alloc-check  Fail if any fixed step after the first W steps of a game
+//             allocates, including steps that set up a new level.
+//             Needs a build with -DEASY_ALLOC_TRACK (see easy_alloc.h)
+//             Also prints the allocation report to stderr at exit
+//  --replay   Play one game with the seed and input recorded by
+//             `./main.bin --record FILE` instead of the controller,
+//             one step per recorded step. Sets --games to 1 and
+//             ignores --seconds, --step-us and --seed
+//  --particle-collisions  Bounce particles off of bricks and the paddle
+//             (see `game.particle_collisions`). Fixed steps only
+//
+// Results do not depend on the number of threads
+
+struct sim_options {
+	unsigned int num_games;
+	unsigned int num_threads;
+	double seconds;
+	uint64_t step_ns;
+	unsigned int seed;
+	bool use_evsim;
+	bool alloc_check;
+	uint64_t alloc_warmup_steps;// Per game
+	const char *replay_path;// NULL unless --replay
+	bool particle_collisions;
+};
+
+// Per game, then reduced into totals over all games
+struct sim_stats {
+	uint64_t steps;// Fixed steps, or handled events with --evsim
+	double sim_ns;
+	uint64_t bricks_cleared;
+	uint64_t ball_deaths;
+	uint64_t levels_cleared;
+	uint64_t ball_collisions;
+	unsigned int particle_peak;
+	uint64_t phase_ns[NUM_PHASES];
+	uint64_t end_hash;// `replay_hash` after the last step. Not reduced
+};
+
+// If `arg` is not a whole number, prints to stderr and exits
+static unsigned long parse_ulong(const char *const arg) {
+	char *end;
+	const unsigned long value = strtoul(arg, &end, 10);
+
+	if (end == arg || *end != '\0') {
+		fprintf(stderr, "%s: not a whole number: %s\n", __func__, arg);
+		exit(EXIT_FAILURE);
+	}
+
+	return value;
+}
+
+// If anything is wrong with the arguments, prints to stderr and exits
+static void parse_options(
+	struct sim_options *const options,
+	const int argc,
+	char **const argv)
+{
+	*options = (struct sim_options) {
+		.num_games = 1,
+		.num_threads = 1,
+		.seconds = 600.0,
+		.step_ns = 16667000,
+		.seed = 1,
+		.use_evsim = false,
+		.alloc_check = false,
+		.alloc_warmup_steps = 0,
+		.replay_path = NULL,
+		.particle_collisions = false
+	};
+
+	for (int i = 1; i < argc; i += 1) {
+		const bool has_value = i + 1 < argc;
+
+		if (strcmp(argv[i], "--evsim") == 0) {
+			options->use_evsim = true;
+		}
+		else if (strcmp(argv[i], "--particle-collisions") == 0) {
+			options->particle_collisions = true;
+		}
+		else if (strcmp(argv[i], "--games") == 0 && has_value) {
+			i += 1;
+			options->num_games = parse_ulong(argv[i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+			i += 1;
+			options->num_threads = parse_ulong(argv[i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+			i += 1;
+			options->seconds = parse_ulong(argv[i]);
+		}
+		else if (strcmp(argv[i], "--step-us") == 0 && has_value) {
+			i += 1;
+			options->step_ns = parse_ulong(argv[i]) * 1000;
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+			i += 1;
+			options->seed = parse_ulong(argv[i]);
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+			i += 1;
+			options->replay_path = argv[i];
+			options->num_games = 1;
+		}
+		else if (strcmp(argv[i], "--alloc-check") == 0 && has_value) {
+			i += 1;
+			options->alloc_check = true;
+			options->alloc_warmup_steps = parse_ulong(argv[i]);
+		}
+		else {
+			fprintf(stderr, "%s: unknown or incomplete argument: %s\n",
+				__func__, argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (options->step_ns == 0) {
+		fprintf(stderr, "%s: --step-us must be at least 1\n", __func__);
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->alloc_check && !EASY_ALLOC_TRACKING) {
+		fprintf(stderr, "%s: --alloc-check needs a build with "
+			"-DEASY_ALLOC_TRACK\n", __func__);
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->alloc_check && options->use_evsim) {
+		fprintf(stderr, "%s: --alloc-check only checks fixed steps\n",
+			__func__);
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->replay_path != NULL && options->use_evsim) {
+		fprintf(stderr, "%s: --replay plays fixed steps, not --evsim\n",
+			__func__);
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->replay_path != NULL) {
+		options->num_games = 1;
+	}
+}
+
+// Same frame as `game_step`, with each phase timed
+// If `replay` is not NULL, plays its steps instead of `options->seconds`
+static void run_fixed(
+	struct game *const game,
+	const struct sim_options *const options,
+	const struct replay *const replay,
+	struct sim_stats *const stats)
+{
+	const double end_ns = options->seconds * 1000000000.0;
+	double time = 0.0;
+
+	uint64_t phase_ticks[NUM_PHASES] = {0};
+
+	while (replay == NULL ? time < end_ns : stats->steps < replay->num_steps) {
+		const struct replay_step *const input =
+			replay == NULL ? NULL : &replay->steps[stats->steps];
+		const uint64_t delta = input == NULL ? options->step_ns : input->delta;
+
+		// Same rule as the windowed game
+		const bool dead = game->num_balls == 0 && game->particles.num == 0;
+		const bool level_cleared =
+			game->num_bricks == 0 && game->particles.num == 0;
+
+		if (level_cleared) {
+			stats->levels_cleared += 1;
+		}
+
+		const uint64_t num_allocs = easy_alloc_thread_count();
+
+		if (dead || level_cleared) {
+			game_setup(game);
+		}
+
+		const unsigned int num_balls = game->num_balls;
+		const unsigned int num_bricks = game->num_bricks;
+
+		stats->ball_collisions +=
+			phases_step(game, delta, input, phase_ticks);
+
+		// Balls and bricks are only removed by `game_update_balls`,
+		//  unless a recorded reset set up the level again first
+		if (input == NULL || !input->reset) {
+			stats->ball_deaths += num_balls - game->num_balls;
+			stats->bricks_cleared += num_bricks - game->num_bricks;
+		}
+
+		if (game->particles.num > stats->particle_peak) {
+			stats->particle_peak = game->particles.num;
+		}
+
+		// Neither a level's setup nor its steps should allocate
+		if (options->alloc_check
+			&& stats->steps >= options->alloc_warmup_steps
+			&& easy_alloc_thread_count() != num_allocs)
+		{
+			fprintf(stderr, "%s: step %lu allocated %lu times (last at %s)\n",
+				__func__,
+				(unsigned long)stats->steps,
+				(unsigned long)(easy_alloc_thread_count() - num_allocs),
+				easy_alloc_thread_last_site());
+			exit(EXIT_FAILURE);
+		}
+
+		stats->steps += 1;
+		time += delta;
+	}
+
+	stats->sim_ns += time;
+	stats->end_hash = replay_hash(game);
+
+	for (unsigned int i = 0; i < NUM_PHASES; i += 1) {
+		stats->phase_ns[i] += nsec_ticks_to_ns(phase_ticks[i]);
+	}
+}
+
+// Fast-forward with the event engine and its own paddle controller
+// Particles and the camera are not simulated
+static void run_evsim(
+	struct game *const game,
+	struct evsim *const sim,
+	const struct sim_options *const options,
+	struct sim_stats *const stats)
+{
+	const double end_ns = options->seconds * 1000000000.0;
+	double time = 0.0;
+
+	sim->auto_paddle = true;
+
+	while (time < end_ns) {
+		evsim_begin(sim, game);
+
+		const enum evsim_result result = evsim_run_until(sim, end_ns - time);
+
+		time += sim->time;
+		stats->steps += sim->stats.num_events;
+		stats->bricks_cleared += sim->stats.bricks_cleared;
+		stats->ball_deaths += sim->stats.ball_deaths;
+
+		evsim_end(sim);
+
+		if (result == EVSIM_LEVEL_CLEARED) {
+			stats->levels_cleared += 1;
+		}
+
+		if (result != EVSIM_REACHED_TIME) {
+			game_setup(game);
+		}
+	}
+
+	stats->sim_ns += time;
+}
+
+// Add `game` into `total`
+static void reduce_stats(
+	struct sim_stats *const total,
+	const struct sim_stats *const game)
+{
+	total->steps += game->steps;
+	total->sim_ns += game->sim_ns;
+	total->bricks_cleared += game->bricks_cleared;
+	total->ball_deaths += game->ball_deaths;
+	total->levels_cleared += game->levels_cleared;
+	total->ball_collisions += game->ball_collisions;
+
+	if (game->particle_peak > total->particle_peak) {
+		total->particle_peak = game->particle_peak;
+	}
+
+	for (unsigned int i = 0; i < NUM_PHASES; i += 1) {
+		total->phase_ns[i] += game->phase_ns[i];
+	}
+}
+
+// `replay` is NULL unless --replay
+static void print_json(
+	const struct sim_options *const options,
+	const struct replay *const replay,
+	const unsigned int num_threads,
+	const struct sim_stats *const stats,
+	const uint64_t wall_ns)
+{
+	const double wall_s = wall_ns / 1000000000.0;
+
+	printf("{\n");
+	printf("\t\"engine\": \"%s\",\n", options->use_evsim ? "evsim" : "fixed");
+	printf("\t\"particle_collisions\": %s,\n",
+		options->particle_collisions ? "true" : "false");
+	printf("\t\"games\": %u,\n", options->num_games);
+	printf("\t\"threads\": %u,\n", num_threads);
+	if (replay == NULL) {
+		printf("\t\"seed\": %u,\n", options->seed);
+	}
+	else {
+		printf("\t\"replay\": \"%s\",\n", options->replay_path);
+		printf("\t\"seed\": %lu,\n", (unsigned long)replay->seed);
+		// One game, so `end_hash` is that game's
+		printf("\t\"replay_matches\": %s,\n",
+			stats->end_hash == replay->end_hash ? "true" : "false");
+	}
+	// A replay's steps are as long as they were when recorded
+	if (replay == NULL) {
+		printf("\t\"step_ns\": %lu,\n", (unsigned long)options->step_ns);
+	}
+	else {
+		printf("\t\"mean_step_ns\": %.0f,\n", stats->steps == 0
+			? 0.0
+			: (double)stats->sim_ns / stats->steps);
+	}
+	printf("\t\"sim_seconds\": %.3f,\n", stats->sim_ns / 1000000000.0);
+	printf("\t\"wall_seconds\": %.6f,\n", wall_s);
+	printf("\t\"steps\": %lu,\n", (unsigned long)stats->steps);
+	printf("\t\"steps_per_sec\": %.1f,\n",
+		wall_s > 0.0 ? stats->steps / wall_s : 0.0);
+	printf("\t\"sim_speedup\": %.1f,\n",
+		wall_s > 0.0 ? (stats->sim_ns / 1000000000.0) / wall_s : 0.0);
+	printf("\t\"bricks_cleared\": %lu,\n",
+		(unsigned long)stats->bricks_cleared);
+	printf("\t\"ball_deaths\": %lu,\n", (unsigned long)stats->ball_deaths);
+	printf("\t\"levels_cleared\": %lu,\n",
+		(unsigned long)stats->levels_cleared);
+	printf("\t\"ball_collisions\": %lu,\n",
+		(unsigned long)stats->ball_collisions);
+	printf("\t\"particle_peak\": %u,\n", stats->particle_peak);
+
+	// Phases are only timed for fixed steps. Summed over threads
+	printf("\t\"phase_ns_per_step\": {");
+	for (unsigned int i = 0; i < NUM_PHASES; i += 1) {
+		const double per_step = (options->use_evsim || stats->steps == 0)
+			? 0.0
+			: (double)stats->phase_ns[i] / stats->steps;
+
+		printf("%s\n\t\t\"%s\": %.1f",
+			i == 0 ? "" : ",", phase_names[i], per_step);
+	}
+	printf("\n\t}\n");
+	printf("}\n");
+}
+
+struct sim_run {
+	const struct sim_options *options;
+	struct sim_stats *game_stats;// One per game
+	bool parallel;// Value for `game.parallel`
+	const struct replay *replay;// NULL unless --replay
+};
+
+// Pool task: play game `task` with its own state from start to end
+static void run_game(void *const data, const unsigned int task,
+	const unsigned int worker)
+{
+	(void)worker;
+
+	const struct sim_run *const run = data;
+	const struct sim_options *const options = run->options;
+	struct sim_stats *const stats = &run->game_stats[task];
+
+	memset(stats, 0, sizeof(*stats));
+
+	struct game game;
+	game_init(&game);
+	game_seed(&game, run->replay == NULL
+		? (uint64_t)options->seed + task
+		: run->replay->seed);
+
+	game.parallel = run->parallel;
+	game.particle_collisions = options->particle_collisions;
+
+	game_setup(&game);
+
+	if (options->use_evsim) {
+		struct evsim sim;
+		evsim_init(&sim);
+
+		run_evsim(&game, &sim, options, stats);
+
+		evsim_deinit(&sim);
+	}
+	else {
+		run_fixed(&game, options, run->replay, stats);
+	}
+
+	game_desetup(&game);
+	game_deinit(&game);
+}
+
+int main(int argc, char **argv) {
+	struct sim_options options;
+	parse_options(&options, argc, argv);
+
+	unsigned int num_threads = (options.num_threads == 0)
+		? pool_num_cores()
+		: options.num_threads;
+
+	if (num_threads > options.num_games && options.num_games > 0) {
+		num_threads = options.num_games;
+	}
+
+	struct replay replay;
+	if (options.replay_path != NULL) {
+		replay_read(&replay, options.replay_path);
+	}
+
+	struct sim_run run = {
+		.options = &options,
+		.game_stats = easy_malloc(
+			sizeof(struct sim_stats) * (options.num_games + 1)),
+		// With more than one thread the pool already keeps the cores busy
+		.parallel = num_threads == 1,
+		.replay = options.replay_path == NULL ? NULL : &replay
+	};
+
+	// Before any game thread converts ticks
+	nsec_calibrate();
+
+	const uint64_t start = nsec_time();
+
+	pool_run(num_threads, options.num_games, run_game, &run);
+
+	// Reduce in game order so the totals are the same for any thread count
+	struct sim_stats total;
+	memset(&total, 0, sizeof(total));
+
+	for (unsigned int i = 0; i < options.num_games; i += 1) {
+		reduce_stats(&total, &run.game_stats[i]);
+	}
+
+	if (run.replay != NULL) {
+		total.end_hash = run.game_stats[0].end_hash;
+	}
+
+	const uint64_t wall_ns = nsec_time() - start;
+
+	print_json(&options, run.replay, num_threads, &total, wall_ns);
+
+	const bool replay_failed = run.replay != NULL
+		&& total.end_hash != replay.end_hash;
+
+	easy_free(run.game_stats);
+
+	if (run.replay != NULL) {
+		replay_deinit(&replay);
+	}
+
+	if (options.alloc_check) {
+		easy_alloc_print_report(stderr);
+	}
+
+	if (replay_failed) {
+		fprintf(stderr, "%s: replay did not end the same as recorded\n",
+			__func__);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+#include "brick_grid.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easy_alloc.h"
+
+// [0, 1] to sixteenths (1.0 wraps around to 0)
+static uint8_t quantize_phase(const double phase) {
+	return (uint8_t)((int)(phase * 16.0) & 0xF);
+}
+
+// Units/ns to 4-bit two's complement in [-7, 7]
+static uint8_t quantize_speed(const double speed) {
+	int q = (int)lround(speed / BRICK_GRID_MAX_SPEED * 7.0);
+
+	if (q > 7) {
+		q = 7;
+	}
+	else if (q < -7) {
+		q = -7;
+	}
+
+	return (uint8_t)(q & 0xF);
+}
+
+static double dequantize_speed(const uint8_t bits) {
+	// Sign extend from 4 bits
+	const int q = (bits & 0x8) ? (int)bits - 16 : (int)bits;
+
+	return q * (BRICK_GRID_MAX_SPEED / 7.0);
+}
+
+void brick_grid_init(
+	struct brick_grid *const grid,
+	const double origin_x,
+	const double origin_y,
+	const double brick_size_x,
+	const double brick_size_y,
+	const double margin_x,
+	const double margin_y,
+	const unsigned int num_columns,
+	const unsigned int num_rows)
+{
+	if (num_rows != 0 && num_columns > UINT_MAX / num_rows) {
+		fprintf(stderr, "%s: %u by %u cells is too many\n",
+			__func__, num_columns, num_rows);
+		exit(EXIT_FAILURE);
+	}
+
+	grid->origin_x = origin_x;
+	grid->origin_y = origin_y;
+	grid->brick_size_x = brick_size_x;
+	grid->brick_size_y = brick_size_y;
+	grid->margin_x = margin_x;
+	grid->margin_y = margin_y;
+	grid->num_columns = num_columns;
+	grid->num_rows = num_rows;
+	grid->num_bricks = 0;
+
+	const unsigned int num_cells = brick_grid_num_cells(grid);
+
+	// +1 so that an empty grid does not allocate 0 bytes
+	grid->cells = easy_malloc(sizeof(struct brick_cell) * (num_cells + 1));
+
+	for (unsigned int i = 0; i < num_cells; i += 1) {
+		grid->cells[i] = (struct brick_cell) {
+			.tex_index = BRICK_GRID_EMPTY
+		};
+	}
+}
+
+void brick_grid_deinit(struct brick_grid *const grid) {
+	easy_free(grid->cells);
+}
+
+void brick_grid_set(
+	struct brick_grid *const grid,
+	const unsigned int cell,
+	const struct brick *const brick)
+{
+	if (!brick_grid_has(grid, cell)) {
+		grid->num_bricks += 1;
+	}
+
+	int tex_w = brick->inner_tex_w - BRICK_GRID_TEX_W_MIN;
+
+	if (tex_w < 0) {
+		tex_w = 0;
+	}
+	else if (tex_w > UINT8_MAX) {
+		tex_w = UINT8_MAX;
+	}
+
+	grid->cells[cell] = (struct brick_cell) {
+		.tex_index = brick->inner_tex_index,
+		.tex_w = tex_w,
+		.phase = quantize_phase(brick->inner_tex_x_prop)
+			| (quantize_phase(brick->inner_tex_y_prop) << 4),
+		.speed = quantize_speed(brick->inner_tex_x_prop_speed)
+			| (quantize_speed(brick->inner_tex_y_prop_speed) << 4)
+	};
+}
+
+void brick_grid_remove(struct brick_grid *const grid, const unsigned int cell) {
+	if (!brick_grid_has(grid, cell)) {
+		return;
+	}
+
+	grid->cells[cell].tex_index = BRICK_GRID_EMPTY;
+	grid->num_bricks -= 1;
+}
+
+void brick_grid_get(
+	const struct brick_grid *const grid,
+	const unsigned int cell,
+	struct brick *const out)
+{
+	const struct brick_cell c = grid->cells[cell];
+
+	const unsigned int column = cell % grid->num_columns;
+	const unsigned int row = cell / grid->num_columns;
+
+	const double pitch_x = grid->brick_size_x + 2.0 * grid->margin_x;
+	const double pitch_y = grid->brick_size_y + 2.0 * grid->margin_y;
+
+	out->pos_x = grid->origin_x + column * pitch_x + grid->margin_x;
+	out->pos_y = grid->origin_y - row * pitch_y - grid->margin_y;
+	out->size_x = grid->brick_size_x;
+	out->size_y = grid->brick_size_y;
+
+	out->inner_tex_index = c.tex_index;
+
+	out->inner_tex_x_prop = (c.phase & 0xF) / 16.0;
+	out->inner_tex_y_prop = (c.phase >> 4) / 16.0;
+
+	out->inner_tex_w = c.tex_w + BRICK_GRID_TEX_W_MIN;
+	out->inner_tex_h = out->inner_tex_w * out->size_y / out->size_x;
+
+	out->inner_tex_x_prop_speed = dequantize_speed(c.speed & 0xF);
+	out->inner_tex_y_prop_speed = dequantize_speed(c.speed >> 4);
+}
+
+unsigned int brick_grid_cell_at(
+	const struct brick_grid *const grid,
+	const double x,
+	const double y)
+{
+	const double pitch_x = grid->brick_size_x + 2.0 * grid->margin_x;
+	const double pitch_y = grid->brick_size_y + 2.0 * grid->margin_y;
+
+	const double column = floor((x - grid->origin_x) / pitch_x);
+	const double row = floor((grid->origin_y - y) / pitch_y);
+
+	if (column < 0.0 || column >= grid->num_columns ||
+	    row < 0.0 || row >= grid->num_rows)
+	{
+		return UINT_MAX;
+	}
+
+	return (unsigned int)row * grid->num_columns + (unsigned int)column;
+}
+
+size_t brick_grid_bytes(const struct brick_grid *const grid) {
+	return sizeof(struct brick_grid)
+		+ sizeof(struct brick_cell) * (size_t)brick_grid_num_cells(grid);
+}
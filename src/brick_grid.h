@@ -0,0 +1,121 @@
+#ifndef BRICK_GRID_H
+#define BRICK_GRID_H
+
+// Compact storage for a level of bricks laid out on a grid
+// Each cell stores only what differs between bricks, in 4 bytes.
+// The cell index is the position in the array and the geometry comes
+//  from the grid, so full `struct brick` values are made on demand.
+// For generated levels too big to keep as full bricks. `game_setup`
+//  does not use it, since the quantized scroll speeds show.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// `tex_index` of a cell with no brick
+#define BRICK_GRID_EMPTY 0xFF
+
+// `inner_tex_w` is stored as an offset from this
+#define BRICK_GRID_TEX_W_MIN 200
+
+// Largest magnitude of `inner_tex_<>_prop_speed` (units/ns)
+// Speeds are stored in 4 bits as a multiple of this divided by 7
+#define BRICK_GRID_MAX_SPEED 0.0000000009
+
+struct brick_cell {
+	uint8_t tex_index;// BRICK_GRID_EMPTY if there is no brick
+	uint8_t tex_w;// inner_tex_w - BRICK_GRID_TEX_W_MIN
+	// Starting inner_tex_<>_prop in sixteenths. x in low 4 bits, y in high
+	uint8_t phase;
+	// inner_tex_<>_prop_speed in [-7, 7] (4-bit two's complement)
+	// x in low 4 bits, y in high
+	uint8_t speed;
+};
+
+struct brick_grid {
+	// Top-left corner of cell 0. Columns go right and rows go down
+	double origin_x;
+	double origin_y;
+
+	double brick_size_x;
+	double brick_size_y;
+	// Space on each side of a brick inside its cell
+	double margin_x;
+	double margin_y;
+
+	unsigned int num_columns;
+	unsigned int num_rows;
+
+	unsigned int num_bricks;// Cells that are not empty
+
+	// Row-major. Length is num_columns * num_rows
+	struct brick_cell *cells;
+};
+
+// Allocate a grid with every cell empty
+// If the grid would have more than UINT_MAX cells, prints to stderr and exits
+void brick_grid_init(
+	struct brick_grid *const grid,
+	const double origin_x,
+	const double origin_y,
+	const double brick_size_x,
+	const double brick_size_y,
+	const double margin_x,
+	const double margin_y,
+	const unsigned int num_columns,
+	const unsigned int num_rows);
+
+void brick_grid_deinit(struct brick_grid *const grid);
+
+static inline unsigned int brick_grid_num_cells(
+	const struct brick_grid *const grid)
+{
+	return grid->num_columns * grid->num_rows;
+}
+
+static inline bool brick_grid_has(
+	const struct brick_grid *const grid,
+	const unsigned int cell)
+{
+	return grid->cells[cell].tex_index != BRICK_GRID_EMPTY;
+}
+
+// Store the parts of `brick` that are not implied by the grid
+// The position and size of `brick` are ignored
+// Values are quantized: `brick_grid_get` will not return exactly `brick`.
+//  Scroll speeds of less than BRICK_GRID_MAX_SPEED / 14 become 0, so
+//  for `game_setup`'s random speeds about half of them do
+void brick_grid_set(
+	struct brick_grid *const grid,
+	const unsigned int cell,
+	const struct brick *const brick);
+
+void brick_grid_remove(struct brick_grid *const grid, const unsigned int cell);
+
+// Make the full brick in `cell`, which must not be empty
+void brick_grid_get(
+	const struct brick_grid *const grid,
+	const unsigned int cell,
+	struct brick *const out);
+
+// Returns the cell that contains game coordinate (x, y)
+//  (margins included), or UINT_MAX if outside of the grid
+unsigned int brick_grid_cell_at(
+	const struct brick_grid *const grid,
+	const double x,
+	const double y);
+
+// Bytes used by the grid, including the struct itself
+size_t brick_grid_bytes(const struct brick_grid *const grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
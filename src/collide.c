@@ -0,0 +1,419 @@
+#include "collide.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "easy_alloc.h"
+
+#if defined(__GNUC__) && !defined(COLLIDE_SCALAR)
+#define COLLIDE_VECTOR
+#endif
+
+/* Overlap formula from: https://stackoverflow.com/questions/306316/
+determine-if-two-rectangles-overlap-each-other */
+bool rects_overlap(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh)
+{
+	// We need right and bottom for both rects
+
+	const double ar = ax + aw;
+	const double ab = ay - ah;
+
+	const double br = bx + bw;
+	const double bb = by - bh;
+
+	return ax < br && ar > bx && ay > bb && ab < by;
+}
+
+/* Based on: https://gamedev.stackexchange.com/questions/29786/a-simple-
+2d-rectangle-collision-algorithm-that-also-determines-which-sides-that */
+// `dx` and `dy` go from the center of b to the center of a
+// `w` and `h` are the sums of the half sizes
+static enum collision collide_centers(
+	const double dx,
+	const double dy,
+	const double w,
+	const double h)
+{
+	if (fabs(dx) <= w && fabs(dy) <= h) {
+		const double wy = w * dy;
+		const double hx = h * dx;
+
+		if (wy > hx) {
+			if (wy > -hx) {
+				return COLL_BOTTOM;
+			}
+
+			return COLL_RIGHT;
+		}
+		else {
+			if (wy > -hx) {
+				return COLL_LEFT;
+			}
+
+			return COLL_TOP;
+		}
+	}
+
+	return COLL_NONE;
+}
+
+enum collision collide_rects(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh)
+{
+	const double a_center_x = ax + (aw * 0.5);
+	const double a_center_y = ay - (ah * 0.5);
+
+	const double b_center_x = bx + (bw * 0.5);
+	const double b_center_y = by - (bh * 0.5);
+
+	const double w = 0.5 * (aw + bw);
+	const double h = 0.5 * (ah + bh);
+
+	return collide_centers(
+		a_center_x - b_center_x, a_center_y - b_center_y, w, h);
+}
+
+void collide_boxes_init(struct collide_boxes *const boxes) {
+	boxes->len = 128;
+	boxes->num = 0;
+	boxes->center_x = easy_malloc(sizeof(double) * boxes->len);
+	boxes->center_y = easy_malloc(sizeof(double) * boxes->len);
+	boxes->half_x = easy_malloc(sizeof(double) * boxes->len);
+	boxes->half_y = easy_malloc(sizeof(double) * boxes->len);
+}
+
+void collide_boxes_deinit(struct collide_boxes *const boxes) {
+	easy_free(boxes->center_x);
+	easy_free(boxes->center_y);
+	easy_free(boxes->half_x);
+	easy_free(boxes->half_y);
+}
+
+// Up to the end of the last lane of `num` boxes
+static unsigned int boxes_end(const unsigned int num) {
+	return (num + COLLIDE_LANES - 1) / COLLIDE_LANES * COLLIDE_LANES;
+}
+
+// Make the arrays at least `len` long
+static void boxes_grow(
+	struct collide_boxes *const boxes,
+	const unsigned int len)
+{
+	if (len <= boxes->len) {
+		return;
+	}
+
+	while (len > boxes->len) {
+		boxes->len *= 2;
+	}
+
+	boxes->center_x = easy_realloc(boxes->center_x,
+		sizeof(double) * boxes->len);
+	boxes->center_y = easy_realloc(boxes->center_y,
+		sizeof(double) * boxes->len);
+	boxes->half_x = easy_realloc(boxes->half_x,
+		sizeof(double) * boxes->len);
+	boxes->half_y = easy_realloc(boxes->half_y,
+		sizeof(double) * boxes->len);
+}
+
+void collide_boxes_reserve(
+	struct collide_boxes *const boxes,
+	const unsigned int num)
+{
+	boxes_grow(boxes, boxes_end(num));
+}
+
+void collide_boxes_resize(
+	struct collide_boxes *const boxes,
+	const unsigned int num)
+{
+	const unsigned int end = boxes_end(num);
+	boxes_grow(boxes, end);
+
+	boxes->num = num;
+
+	// A negative infinite half size fails `fabs(dx) <= w` for any rect
+	for (unsigned int i = num; i < end; i += 1) {
+		boxes->center_x[i] = 0.0;
+		boxes->center_y[i] = 0.0;
+		boxes->half_x[i] = -INFINITY;
+		boxes->half_y[i] = -INFINITY;
+	}
+}
+
+void collide_boxes_set(
+	struct collide_boxes *const boxes,
+	const unsigned int i,
+	const double x,
+	const double y,
+	const double w,
+	const double h)
+{
+	// Same centers as `collide_rects`. Halving is exact, so adding two
+	//  halves gives the same sum as halving the sum of the sizes
+	boxes->center_x[i] = x + (w * 0.5);
+	boxes->center_y[i] = y - (h * 0.5);
+	boxes->half_x[i] = w * 0.5;
+	boxes->half_y[i] = h * 0.5;
+}
+
+#ifdef COLLIDE_VECTOR
+
+// Lanes in one hardware vector register. The compiler splits wider
+//  vector types into scalar code, not into several registers
+#ifdef __AVX__
+#define COLLIDE_VEC_LANES 4
+#else
+#define COLLIDE_VEC_LANES 2
+#endif
+
+typedef double collide_vec
+	__attribute__((vector_size(COLLIDE_VEC_LANES * sizeof(double))));
+// Result of comparing two `collide_vec`: -1 where true, 0 where false
+typedef int64_t collide_mask
+	__attribute__((vector_size(COLLIDE_VEC_LANES * sizeof(int64_t))));
+
+// `collide_centers` for each lane without branches
+unsigned int collide_boxes_test(
+	const struct collide_boxes *const boxes,
+	const unsigned int first,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	uint8_t out_colls[COLLIDE_LANES])
+{
+	const double b_center_x = bx + (bw * 0.5);
+	const double b_center_y = by - (bh * 0.5);
+	const double b_half_x = bw * 0.5;
+	const double b_half_y = bh * 0.5;
+
+	const double *const center_xs = &boxes->center_x[first];
+	const double *const center_ys = &boxes->center_y[first];
+	const double *const half_xs = &boxes->half_x[first];
+	const double *const half_ys = &boxes->half_y[first];
+
+	unsigned int mask = 0;
+
+	for (unsigned int v = 0; v < COLLIDE_LANES; v += COLLIDE_VEC_LANES) {
+		// The arrays are not aligned to lanes, so load with memcpy
+		collide_vec center_x;
+		collide_vec center_y;
+		collide_vec half_x;
+		collide_vec half_y;
+		memcpy(&center_x, &center_xs[v], sizeof(collide_vec));
+		memcpy(&center_y, &center_ys[v], sizeof(collide_vec));
+		memcpy(&half_x, &half_xs[v], sizeof(collide_vec));
+		memcpy(&half_y, &half_ys[v], sizeof(collide_vec));
+
+		const collide_vec w = half_x + b_half_x;
+		const collide_vec h = half_y + b_half_y;
+		const collide_vec dx = center_x - b_center_x;
+		const collide_vec dy = center_y - b_center_y;
+
+		const collide_mask hit =
+			(dx <= w) & (-dx <= w) & (dy <= h) & (-dy <= h);
+
+		unsigned int vec_mask = 0;
+
+		for (unsigned int k = 0; k < COLLIDE_VEC_LANES; k += 1) {
+			vec_mask |= (unsigned int)(hit[k] & 1) << k;
+		}
+
+		// Nearly every test misses, so only work out sides on a hit
+		if (vec_mask == 0) {
+			continue;
+		}
+
+		mask |= vec_mask << v;
+
+		const collide_vec wy = w * dy;
+		const collide_vec hx = h * dx;
+
+		const collide_mask wy_over_hx = wy > hx;
+		const collide_mask wy_over_neg_hx = wy > -hx;
+
+		const collide_mask coll =
+			(wy_over_hx & ((wy_over_neg_hx & COLL_BOTTOM)
+				| (~wy_over_neg_hx & COLL_RIGHT)))
+			| (~wy_over_hx & ((wy_over_neg_hx & COLL_LEFT)
+				| (~wy_over_neg_hx & COLL_TOP)));
+
+		for (unsigned int k = 0; k < COLLIDE_VEC_LANES; k += 1) {
+			out_colls[v + k] = (uint8_t)(coll[k] & hit[k]);
+		}
+	}
+
+	return mask;
+}
+
+#else
+
+unsigned int collide_boxes_test(
+	const struct collide_boxes *const boxes,
+	const unsigned int first,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	uint8_t out_colls[COLLIDE_LANES])
+{
+	const double b_center_x = bx + (bw * 0.5);
+	const double b_center_y = by - (bh * 0.5);
+
+	unsigned int mask = 0;
+
+	for (unsigned int k = 0; k < COLLIDE_LANES; k += 1) {
+		const unsigned int i = first + k;
+
+		const enum collision coll = collide_centers(
+			boxes->center_x[i] - b_center_x,
+			boxes->center_y[i] - b_center_y,
+			boxes->half_x[i] + bw * 0.5,
+			boxes->half_y[i] + bh * 0.5);
+
+		out_colls[k] = (uint8_t)coll;
+		mask |= (unsigned int)(coll != COLL_NONE) << k;
+	}
+
+	return mask;
+}
+
+#endif
+
+// Fraction of the move along one axis at which b started overlapping a
+// `lo` and `hi` bound the b positions that overlap a
+static double entry_time_1d(
+	const double start,
+	const double move,
+	const double lo,
+	const double hi)
+{
+	if (move > 0.0) {
+		return (lo - start) / move;
+	}
+
+	if (move < 0.0) {
+		return (hi - start) / move;
+	}
+
+	// Not moving on this axis so it was always overlapping on this axis
+	return 0.0;
+}
+
+double collide_entry_time(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	const double move_x,
+	const double move_y)
+{
+	// b overlaps a on the x-axis when bx is in (ax - bw, ax + aw)
+	//  and on the y-axis when by is in (ay - ah, ay + bh)
+	const double tx = entry_time_1d(bx - move_x, move_x, ax - bw, ax + aw);
+	const double ty = entry_time_1d(by - move_y, move_y, ay - ah, ay + bh);
+
+	const double t = fmax(tx, ty);
+
+	if (t < 0.0) return 0.0;
+	if (t > 1.0) return 1.0;
+
+	return t;
+}
+
+// Set the times at which b starts and stops overlapping a on one axis
+// `lo` and `hi` bound the b positions that overlap a (exclusive)
+// Returns false if b never overlaps a on this axis
+static bool sweep_1d(
+	const double start,
+	const double vel,
+	const double lo,
+	const double hi,
+	double *const out_enter,
+	double *const out_exit)
+{
+	if (vel > 0.0) {
+		*out_enter = (lo - start) / vel;
+		*out_exit = (hi - start) / vel;
+		return true;
+	}
+
+	if (vel < 0.0) {
+		*out_enter = (hi - start) / vel;
+		*out_exit = (lo - start) / vel;
+		return true;
+	}
+
+	// Not moving on this axis so it always or never overlaps
+	*out_enter = -INFINITY;
+	*out_exit = INFINITY;
+
+	return start > lo && start < hi;
+}
+
+bool collide_sweep(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	const double vel_x,
+	const double vel_y,
+	double *const out_time,
+	enum collision *const out_coll)
+{
+	double x_enter;
+	double x_exit;
+	double y_enter;
+	double y_exit;
+
+	// Same bounds as `collide_entry_time`
+	if (!sweep_1d(bx, vel_x, ax - bw, ax + aw, &x_enter, &x_exit) ||
+	    !sweep_1d(by, vel_y, ay - ah, ay + bh, &y_enter, &y_exit))
+	{
+		return false;
+	}
+
+	const double enter = fmax(x_enter, y_enter);
+	const double exit = fmin(x_exit, y_exit);
+
+	if (enter < 0.0 || enter >= exit) {
+		return false;
+	}
+
+	*out_time = enter;
+
+	// The axis that started overlapping last is the side that was hit
+	if (x_enter > y_enter) {
+		*out_coll = (vel_x > 0.0) ? COLL_LEFT : COLL_RIGHT;
+	}
+	else {
+		*out_coll = (vel_y < 0.0) ? COLL_TOP : COLL_BOTTOM;
+	}
+
+	return true;
+}
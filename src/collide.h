@@ -0,0 +1,139 @@
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+// Axis-aligned rectangle collision tests
+// Rects are given by top-left `pos` and `size` like in game.h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum collision {
+	COLL_NONE = 0,
+	COLL_TOP,
+	COLL_RIGHT,
+	COLL_BOTTOM,
+	COLL_LEFT
+};
+
+// Returns true if rects a and b overlap
+bool rects_overlap(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh);
+
+// Returns COLL_TOP if b hits the top of a, etc.
+enum collision collide_rects(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh);
+
+// Rects that `collide_boxes_test` checks at once
+#define COLLIDE_LANES 8
+
+// Many rects stored as centers and half sizes, one array per value,
+//  so that `collide_boxes_test` can load COLLIDE_LANES of each at once
+// The arrays always hold a whole number of lanes. Boxes past `num`
+//  never collide with anything
+struct collide_boxes {
+	unsigned int len;// Allocated length of each array
+	unsigned int num;
+	double *center_x;
+	double *center_y;
+	double *half_x;
+	double *half_y;
+};
+
+void collide_boxes_init(struct collide_boxes *const boxes);
+
+void collide_boxes_deinit(struct collide_boxes *const boxes);
+
+// Make room for `num` boxes so that resizing up to that does not allocate
+void collide_boxes_reserve(
+	struct collide_boxes *const boxes,
+	const unsigned int num);
+
+// Make room for and hold `num` boxes
+// Boxes below `num` that were already set are kept
+void collide_boxes_resize(
+	struct collide_boxes *const boxes,
+	const unsigned int num);
+
+// Set box `i` from a rect given by top-left `pos` and `size`
+void collide_boxes_set(
+	struct collide_boxes *const boxes,
+	const unsigned int i,
+	const double x,
+	const double y,
+	const double w,
+	const double h);
+
+// `collide_rects` with boxes `first` to `first + COLLIDE_LANES - 1`
+//  as rect a and the given rect as b. `first` is a multiple of
+//  COLLIDE_LANES
+// Returns a mask with bit k set if box `first + k` collides, and for
+//  each such k sets `out_colls[k]` to the `enum collision` for it
+// The other `out_colls` are not meaningful
+// Uses vector types unless COLLIDE_SCALAR is defined or the compiler
+//  does not have them. The results are the same either way
+unsigned int collide_boxes_test(
+	const struct collide_boxes *const boxes,
+	const unsigned int first,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	uint8_t out_colls[COLLIDE_LANES]);
+
+// Rect b is overlapping rect a after having moved by (`move_x`, `move_y`)
+// Returns the fraction [0, 1] of that move at which b first touched a
+// Returns 0.0 if b was already touching a before the move
+double collide_entry_time(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	const double move_x,
+	const double move_y);
+
+// Rect b moves with velocity (`vel_x`, `vel_y`) relative to rect a
+// If b is going to start overlapping a at some time >= 0, returns true
+//  and sets `out_time` to that time and `out_coll` to the side of a that
+//  b hits (like `collide_rects`)
+// Rects that are only touching do not overlap
+bool collide_sweep(
+	const double ax,
+	const double ay,
+	const double aw,
+	const double ah,
+	const double bx,
+	const double by,
+	const double bw,
+	const double bh,
+	const double vel_x,
+	const double vel_y,
+	double *const out_time,
+	enum collision *const out_coll);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
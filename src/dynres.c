@@ -0,0 +1,71 @@
+#include "dynres.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Every change multiplies or divides the scale by this
+#define DYNRES_STEP_DOWN 0.85
+#define DYNRES_STEP_UP 0.95
+
+void dynres_init(
+	struct dynres *const dynres,
+	const double budget_ns,
+	const double min_scale)
+{
+	if (!(min_scale > 0.0 && min_scale <= 1.0)) {
+		fprintf(stderr, "%s: min_scale must be in (0, 1]. Got %f\n",
+			__func__, min_scale);
+		exit(EXIT_FAILURE);
+	}
+
+	dynres->scale = 1.0;
+	dynres->min_scale = min_scale;
+	dynres->budget_ns = budget_ns;
+	dynres->average_ns = 0.0;
+	dynres->frames_since_change = 0;
+}
+
+bool dynres_update(struct dynres *const dynres, const uint64_t frame_ns) {
+	// Moving average over about the last 8 frames
+	dynres->average_ns += (frame_ns - dynres->average_ns) / 8.0;
+	dynres->frames_since_change += 1;
+
+	if (dynres->frames_since_change < DYNRES_SETTLE_FRAMES) {
+		return false;
+	}
+
+	double scale = dynres->scale;
+
+	if (dynres->average_ns > DYNRES_OVER_BUDGET * dynres->budget_ns) {
+		scale *= DYNRES_STEP_DOWN;
+
+		if (scale < dynres->min_scale) {
+			scale = dynres->min_scale;
+		}
+	}
+	else if (dynres->average_ns < DYNRES_UNDER_BUDGET * dynres->budget_ns) {
+		scale /= DYNRES_STEP_UP;
+
+		if (scale > 1.0) {
+			scale = 1.0;
+		}
+	}
+
+	if (scale == dynres->scale) {
+		return false;
+	}
+
+	dynres->scale = scale;
+	dynres->frames_since_change = 0;
+
+	// Frames at the old scale say little about the new one
+	dynres->average_ns = 0.0;
+
+	return true;
+}
+
+int dynres_pixels(const struct dynres *const dynres, const int window_pixels) {
+	const int pixels = window_pixels * dynres->scale + 0.5;
+
+	return pixels < 1 ? 1 : pixels;
+}
@@ -0,0 +1,51 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+// Dynamic resolution: pick how much of the window's resolution to render
+//  the scene at, from how long frames take
+// Drops the resolution quickly when frames are over budget and raises it
+//  slowly when there is plenty of time left. Between the two thresholds
+//  nothing changes, and after a change there is a wait before the next,
+//  so the scale does not flicker back and forth.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scale down when the average frame takes more than this share of the budget
+#define DYNRES_OVER_BUDGET 0.9
+// Scale up when the average frame takes less than this share of the budget
+#define DYNRES_UNDER_BUDGET 0.6
+// Frames to wait after a change before changing again
+#define DYNRES_SETTLE_FRAMES 30
+
+struct dynres {
+	double scale;// Share of the window's width and height, in (0, 1]
+	double min_scale;
+	double budget_ns;// Time a frame should take at most
+	double average_ns;// Recent frame times, averaged
+	unsigned int frames_since_change;
+};
+
+// If `min_scale` is not in (0, 1], prints to stderr and exits
+void dynres_init(
+	struct dynres *const dynres,
+	const double budget_ns,
+	const double min_scale);
+
+// Give the time the last frame took to render (not counting time spent
+//  waiting for the next frame). Returns true if `scale` changed
+bool dynres_update(struct dynres *const dynres, const uint64_t frame_ns);
+
+// Pixels to render at for a window `window_pixels` wide (or tall)
+// At least 1
+int dynres_pixels(const struct dynres *const dynres, const int window_pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
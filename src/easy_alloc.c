@@ -1,13 +1,126 @@
 #include "easy_alloc.h"
 
 #include <errno.h>
+#include <stdalign.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef EASY_ALLOC_TRACK
+
+#include <stdatomic.h>
+
+// Call sites seen. Sites are string literals, so they are told apart
+//  by address
+#define SITES_LEN 1024
+
+struct site {
+	const char *name;
+	uint64_t num_allocs;
+	uint64_t num_live;
+	size_t live_bytes;
+};
+
+// Put in front of every allocation
+union header {
+	struct {
+		size_t size;
+		unsigned int site;// Index into `sites`
+	} info;
+	max_align_t align;
+};
+
+// `sites` and `totals` are guarded by `lock`
+static atomic_flag lock = ATOMIC_FLAG_INIT;
+static struct site sites[SITES_LEN];
+static struct easy_alloc_stats totals;
+
+static _Thread_local uint64_t thread_num_allocs;
+static _Thread_local const char *thread_last_site;
+
+static void lock_take(void) {
+	while (atomic_flag_test_and_set_explicit(&lock, memory_order_acquire)) {
+	}
+}
+
+static void lock_give(void) {
+	atomic_flag_clear_explicit(&lock, memory_order_release);
+}
+
+// Index of `name` in `sites`, added if new. Call with the lock held
+static unsigned int site_find(const char *const name) {
+	unsigned int i = ((uintptr_t)name >> 3) & (SITES_LEN - 1);
+
+	for (unsigned int probes = 0; probes < SITES_LEN; probes += 1) {
+		if (sites[i].name == name) {
+			return i;
+		}
+
+		if (sites[i].name == NULL) {
+			sites[i].name = name;
+			return i;
+		}
+
+		i = (i + 1) & (SITES_LEN - 1);
+	}
+
+	fprintf(stderr, "%s: More than %d allocation sites\n", __func__, SITES_LEN);
+
+	exit(EXIT_FAILURE);
+}
+
+// Count an allocation of `size` bytes from `name`
+// Returns the site index to keep in the header
+static unsigned int track_alloc(const char *const name, const size_t size) {
+	thread_num_allocs += 1;
+	thread_last_site = name;
+
+	lock_take();
+
+	const unsigned int i = site_find(name);
+
+	sites[i].num_allocs += 1;
+	sites[i].num_live += 1;
+	sites[i].live_bytes += size;
+
+	totals.num_allocs += 1;
+	totals.live_bytes += size;
+
+	if (totals.live_bytes > totals.peak_bytes) {
+		totals.peak_bytes = totals.live_bytes;
+	}
+
+	lock_give();
+
+	return i;
+}
+
+// Count the allocation described by `header` as freed
+static void track_free(const union header *const header) {
+	lock_take();
+
+	sites[header->info.site].num_live -= 1;
+	sites[header->info.site].live_bytes -= header->info.size;
+
+	totals.num_frees += 1;
+	totals.live_bytes -= header->info.size;
+
+	lock_give();
+}
+
+#endif
+
 // Based on
 // https://stackoverflow.com/questions/35026910/malloc-error-checking-methods
-void *easy_malloc(size_t size) {
+void *easy_malloc_at(size_t size, const char *const site) {
+#ifdef EASY_ALLOC_TRACK
+	union header *const header = malloc(sizeof(union header) + size);
+	void *ptr = header;
+#else
+	(void)site;
+
 	void *ptr = malloc(size);
+#endif
 
 	if (ptr == NULL) {
 		fprintf(stderr, "%s: Failed to malloc %zu bytes\n", __func__, size);
@@ -15,11 +128,32 @@ void *easy_malloc(size_t size) {
 		exit(EXIT_FAILURE);
 	}
 
+#ifdef EASY_ALLOC_TRACK
+	header->info.size = size;
+	header->info.site = track_alloc(site, size);
+	ptr = header + 1;
+#endif
+
 	return ptr;
 }
 
-void *easy_realloc(void *ptr, size_t new_size) {
+void *easy_realloc_at(void *ptr, size_t new_size, const char *const site) {
+#ifdef EASY_ALLOC_TRACK
+	// The reallocated memory belongs to the new site
+	union header *header = NULL;
+
+	if (ptr != NULL) {
+		header = (union header*)ptr - 1;
+		track_free(header);
+	}
+
+	header = realloc(header, sizeof(union header) + new_size);
+	ptr = header;
+#else
+	(void)site;
+
 	ptr = realloc(ptr, new_size);
+#endif
 
 	if (ptr == NULL) {
 		fprintf(stderr, "%s: Failed to realloc to %zu bytes\n",
@@ -28,5 +162,190 @@ void *easy_realloc(void *ptr, size_t new_size) {
 		exit(EXIT_FAILURE);
 	}
 
+#ifdef EASY_ALLOC_TRACK
+	header->info.size = new_size;
+	header->info.site = track_alloc(site, new_size);
+	ptr = header + 1;
+#endif
+
+	return ptr;
+}
+
+void easy_free(void *ptr) {
+#ifdef EASY_ALLOC_TRACK
+	if (ptr == NULL) {
+		return;
+	}
+
+	union header *const header = (union header*)ptr - 1;
+	track_free(header);
+	ptr = header;
+#endif
+
+	free(ptr);
+}
+
+void easy_alloc_get_stats(struct easy_alloc_stats *const stats) {
+#ifdef EASY_ALLOC_TRACK
+	lock_take();
+	*stats = totals;
+	lock_give();
+#else
+	*stats = (struct easy_alloc_stats) {0};
+#endif
+}
+
+uint64_t easy_alloc_thread_count(void) {
+#ifdef EASY_ALLOC_TRACK
+	return thread_num_allocs;
+#else
+	return 0;
+#endif
+}
+
+const char *easy_alloc_thread_last_site(void) {
+#ifdef EASY_ALLOC_TRACK
+	return thread_last_site;
+#else
+	return NULL;
+#endif
+}
+
+void easy_alloc_print_report(FILE *const file) {
+#ifdef EASY_ALLOC_TRACK
+	lock_take();
+
+	fprintf(file, "Allocations: %lu allocs, %lu frees, "
+		"%zu bytes live, %zu bytes peak\n",
+		(unsigned long)totals.num_allocs,
+		(unsigned long)totals.num_frees,
+		totals.live_bytes,
+		totals.peak_bytes);
+
+	for (unsigned int i = 0; i < SITES_LEN; i += 1) {
+		const struct site *const site = &sites[i];
+
+		if (site->name == NULL || site->num_live == 0) {
+			continue;
+		}
+
+		fprintf(file, "  %zu bytes in %lu still allocated from %s "
+			"(%lu allocs)\n",
+			site->live_bytes,
+			(unsigned long)site->num_live,
+			site->name,
+			(unsigned long)site->num_allocs);
+	}
+
+	lock_give();
+#else
+	fprintf(file, "Allocations are not tracked. Build with -DEASY_ALLOC_TRACK\n");
+#endif
+}
+
+struct easy_arena_chunk {
+	struct easy_arena_chunk *next;
+	size_t size;// Bytes in `data`
+	alignas(max_align_t) unsigned char data[];
+};
+
+static struct easy_arena_chunk *arena_chunk_new(const size_t size) {
+	struct easy_arena_chunk *const chunk =
+		easy_malloc(sizeof(struct easy_arena_chunk) + size);
+
+	chunk->next = NULL;
+	chunk->size = size;
+
+	return chunk;
+}
+
+void easy_arena_init(struct easy_arena *const arena, const size_t chunk_size) {
+	arena->chunk_size = chunk_size;
+	arena->first = arena_chunk_new(chunk_size);
+	arena->current = arena->first;
+	arena->used = 0;
+}
+
+void easy_arena_deinit(struct easy_arena *const arena) {
+	struct easy_arena_chunk *chunk = arena->first;
+
+	while (chunk != NULL) {
+		struct easy_arena_chunk *const next = chunk->next;
+		easy_free(chunk);
+		chunk = next;
+	}
+}
+
+// `size` rounded up to a multiple of the arena's alignment
+static size_t arena_align(const size_t size) {
+	const size_t align = alignof(max_align_t);
+	const size_t aligned_size = (size + align - 1) & ~(align - 1);
+
+	if (aligned_size < size) {
+		fprintf(stderr, "%s: Failed to allocate %zu bytes\n", __func__, size);
+
+		exit(EXIT_FAILURE);
+	}
+
+	return aligned_size;
+}
+
+// Move on to a chunk with `aligned_size` bytes free if the current one
+//  does not have them
+static void arena_make_room(
+	struct easy_arena *const arena,
+	const size_t aligned_size)
+{
+	// Use up the chunks kept from before the last reset,
+	//  then add new ones after the current chunk
+	while (arena->current->size - arena->used < aligned_size) {
+		struct easy_arena_chunk *next = arena->current->next;
+
+		if (next == NULL || next->size < aligned_size) {
+			const size_t chunk_size = (aligned_size > arena->chunk_size)
+				? aligned_size
+				: arena->chunk_size;
+
+			struct easy_arena_chunk *const chunk = arena_chunk_new(chunk_size);
+			chunk->next = next;
+			arena->current->next = chunk;
+			next = chunk;
+		}
+
+		arena->current = next;
+		arena->used = 0;
+	}
+}
+
+void easy_arena_reserve(
+	struct easy_arena *const arena,
+	const size_t num,
+	const size_t size)
+{
+	const size_t aligned_size = arena_align(size);
+
+	if (num != 0 && aligned_size > SIZE_MAX / num) {
+		fprintf(stderr, "%s: Failed to reserve %zu times %zu bytes\n",
+			__func__, num, size);
+
+		exit(EXIT_FAILURE);
+	}
+
+	arena_make_room(arena, num * aligned_size);
+}
+
+void *easy_arena_alloc(struct easy_arena *const arena, const size_t size) {
+	const size_t aligned_size = arena_align(size);
+
+	arena_make_room(arena, aligned_size);
+
+	void *const ptr = arena->current->data + arena->used;
+	arena->used += aligned_size;
+
 	return ptr;
 }
+
+void easy_arena_reset(struct easy_arena *const arena) {
+	arena->current = arena->first;
+	arena->used = 0;
+}
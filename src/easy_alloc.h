@@ -5,16 +5,98 @@
 	// For `size_t`
 	#include <stddef.h>
 #endif
+#include <stdint.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Build with -DEASY_ALLOC_TRACK to count every allocation by call site
+// Memory from `easy_malloc`/`easy_realloc` must then be freed with
+//  `easy_free`, never `free`
+#ifdef EASY_ALLOC_TRACK
+	#define EASY_ALLOC_TRACKING 1
+#else
+	#define EASY_ALLOC_TRACKING 0
+#endif
+
+// "file.c:123" of the line it is used on
+#define EASY_ALLOC_STR(x) #x
+#define EASY_ALLOC_STR_LINE(line) EASY_ALLOC_STR(line)
+#define EASY_ALLOC_SITE __FILE__ ":" EASY_ALLOC_STR_LINE(__LINE__)
+
 // Do not try to alloc/realloc a size of 0
 //  because malloc/realloc will return NULL and these functions will call `exit`
 //  ?
-void *easy_malloc(size_t size);
-void *easy_realloc(void *ptr, size_t new_size);
+#ifdef EASY_ALLOC_TRACK
+	#define easy_malloc(size) easy_malloc_at((size), EASY_ALLOC_SITE)
+	#define easy_realloc(ptr, new_size) \
+		easy_realloc_at((ptr), (new_size), EASY_ALLOC_SITE)
+#else
+	#define easy_malloc(size) easy_malloc_at((size), NULL)
+	#define easy_realloc(ptr, new_size) easy_realloc_at((ptr), (new_size), NULL)
+#endif
+
+// `site` is only used with EASY_ALLOC_TRACK. Use the macros above
+void *easy_malloc_at(size_t size, const char *const site);
+void *easy_realloc_at(void *ptr, size_t new_size, const char *const site);
+
+void easy_free(void *ptr);
+
+// Totals since the program started. All 0 without EASY_ALLOC_TRACK
+struct easy_alloc_stats {
+	uint64_t num_allocs;// `easy_malloc` and `easy_realloc` calls
+	uint64_t num_frees;
+	size_t live_bytes;
+	size_t peak_bytes;
+};
+
+void easy_alloc_get_stats(struct easy_alloc_stats *const stats);
+
+// Allocations made on the calling thread so far. Compare two calls to
+//  check that some code did not allocate. 0 without EASY_ALLOC_TRACK
+uint64_t easy_alloc_thread_count(void);
+
+// Site of the calling thread's newest allocation. NULL if none
+const char *easy_alloc_thread_last_site(void);
+
+// Print the totals and every site that still has memory allocated
+// Call at exit for a leak report
+void easy_alloc_print_report(FILE *const file);
+
+// Bump allocator for things that all go away at the same time
+// Allocating moves a pointer forward. There is no freeing single
+//  allocations: `easy_arena_reset` gives back everything at once
+//  and keeps the memory for the next round of allocations
+struct easy_arena_chunk;
+
+struct easy_arena {
+	size_t chunk_size;// Size of new chunks, unless an allocation is bigger
+	struct easy_arena_chunk *first;
+	struct easy_arena_chunk *current;// The chunk being allocated from
+	size_t used;// Bytes used of `current`
+};
+
+void easy_arena_init(struct easy_arena *const arena, const size_t chunk_size);
+
+// Free all of the arena's memory
+void easy_arena_deinit(struct easy_arena *const arena);
+
+// Return `size` bytes aligned for any type. Adds a chunk if needed
+void *easy_arena_alloc(struct easy_arena *const arena, const size_t size);
+
+// Make sure that the next `num` allocations of `size` bytes each fit in
+//  the current chunk, moving on to or adding one that fits if needed
+// Kept chunks are reused after a reset, so reserving the most a round
+//  needs at its start makes later rounds not allocate
+void easy_arena_reserve(
+	struct easy_arena *const arena,
+	const size_t num,
+	const size_t size);
+
+// Make all of the arena's memory free to allocate again
+void easy_arena_reset(struct easy_arena *const arena);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,584 @@
+#include "evsim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easy_alloc.h"
+#include "predict.h"
+
+// Returns true if event `a` comes before event `b`
+// Ties are broken by ball index so runs are repeatable
+static bool event_before(
+	const struct evsim_event *const a,
+	const struct evsim_event *const b)
+{
+	if (a->time != b->time) {
+		return a->time < b->time;
+	}
+
+	return a->ball < b->ball;
+}
+
+static void push_event(struct evsim *const sim, const struct evsim_event event) {
+	if (sim->num_events == sim->events_len) {
+		sim->events_len = sim->events_len * 2;
+		sim->events = easy_realloc(
+			sim->events, sizeof(struct evsim_event) * sim->events_len);
+	}
+
+	// Sift up
+	unsigned int i = sim->num_events;
+	sim->num_events += 1;
+
+	while (i > 0) {
+		const unsigned int parent = (i - 1) / 2;
+
+		if (!event_before(&event, &sim->events[parent])) {
+			break;
+		}
+
+		sim->events[i] = sim->events[parent];
+		i = parent;
+	}
+
+	sim->events[i] = event;
+}
+
+static struct evsim_event pop_event(struct evsim *const sim) {
+	const struct evsim_event top = sim->events[0];
+
+	sim->num_events -= 1;
+
+	if (sim->num_events == 0) {
+		return top;
+	}
+
+	// Sift down the last event from the root
+	const struct evsim_event last = sim->events[sim->num_events];
+	unsigned int i = 0;
+
+	while (true) {
+		unsigned int child = 2 * i + 1;
+
+		if (child >= sim->num_events) {
+			break;
+		}
+
+		if (child + 1 < sim->num_events &&
+		    event_before(&sim->events[child + 1], &sim->events[child]))
+		{
+			child += 1;
+		}
+
+		if (!event_before(&sim->events[child], &last)) {
+			break;
+		}
+
+		sim->events[i] = sim->events[child];
+		i = child;
+	}
+
+	sim->events[i] = last;
+
+	return top;
+}
+
+// Paddle left edge at `time` (which must not be before `paddle_time`)
+static double paddle_x_at(const struct evsim *const sim, const double time) {
+	const double x = sim->game->paddle.pos_x
+		+ sim->paddle_vel_x * (time - sim->paddle_time);
+
+	// Stops at the target
+	if (sim->paddle_vel_x > 0.0) {
+		return fmin(x, sim->paddle_target_x);
+	}
+
+	if (sim->paddle_vel_x < 0.0) {
+		return fmax(x, sim->paddle_target_x);
+	}
+
+	return sim->game->paddle.pos_x;
+}
+
+// Move the ball along its path to `time`
+static void advance_ball(
+	struct evsim *const sim,
+	const unsigned int i,
+	const double time)
+{
+	struct ball *const ball = sim->game->balls[i];
+	const double dt = time - sim->ball_times[i];
+
+	ball->pos_x += ball->vel_x * dt;
+	ball->pos_y += ball->vel_y * dt;
+
+	sim->ball_times[i] = time;
+}
+
+// Predict the next event for ball `i`, which must be at the sim's time
+// `bounced` is true when the ball's path just changed, so the paddle
+//  has to aim again if it is going for this ball
+static void predict_ball(
+	struct evsim *const sim,
+	const unsigned int i,
+	const bool bounced)
+{
+	const struct game *const game = sim->game;
+	const struct ball *const ball = game->balls[i];
+
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_right = game->play_area_origin_x
+		+ (game->play_area_size_x / 2.0);
+
+	const double play_area_top = game->play_area_origin_y
+		+ (game->play_area_size_y / 2.0);
+
+	const double play_area_bottom = game->play_area_origin_y
+		- (game->play_area_size_y / 2.0);
+
+	struct evsim_event next = {
+		.time = INFINITY,
+		.coll = COLL_NONE,
+		.ball = i,
+		.brick = 0,
+		.version = sim->ball_versions[i]
+	};
+
+	// Walls and floor. Times are from now
+
+	if (ball->vel_x < 0.0) {
+		next.type = EVSIM_WALL_LEFT;
+		next.time = (play_area_left - ball->pos_x) / ball->vel_x;
+	}
+	else if (ball->vel_x > 0.0) {
+		next.type = EVSIM_WALL_RIGHT;
+		next.time = (play_area_right - ball->size_x - ball->pos_x)
+			/ ball->vel_x;
+	}
+
+	if (ball->vel_y > 0.0) {
+		const double t = (play_area_top - ball->pos_y) / ball->vel_y;
+
+		if (t < next.time) {
+			next.type = EVSIM_WALL_TOP;
+			next.time = t;
+		}
+	}
+	else if (ball->vel_y < 0.0) {
+		const double t = (play_area_bottom + ball->size_y - ball->pos_y)
+			/ ball->vel_y;
+
+		if (t < next.time) {
+			next.type = EVSIM_FLOOR;
+			next.time = t;
+		}
+	}
+
+	// Paddle, using the current leg of its trajectory
+	{
+		double t;
+		enum collision coll;
+
+		const bool hit = collide_sweep(
+			paddle_x_at(sim, sim->time),
+			game->paddle.pos_y,
+			game->paddle.size_x,
+			game->paddle.size_y,
+			ball->pos_x,
+			ball->pos_y,
+			ball->size_x,
+			ball->size_y,
+			ball->vel_x - sim->paddle_vel_x,
+			ball->vel_y,
+			&t,
+			&coll);
+
+		// If the paddle stops first, this is predicted again when it does
+		const double paddle_stop = (sim->paddle_vel_x == 0.0) ? INFINITY
+			: (sim->paddle_target_x - paddle_x_at(sim, sim->time))
+				/ sim->paddle_vel_x;
+
+		// Only the top of the paddle is solid. A ball that gets to the side
+		//  of the paddle is already below its top and is going to die.
+		// (Otherwise the paddle could pin a ball against a wall forever)
+		if (hit && coll == COLL_TOP && t < next.time && t <= paddle_stop) {
+			next.type = EVSIM_PADDLE;
+			next.time = t;
+			next.coll = coll;
+		}
+	}
+
+	// Bricks
+	for (unsigned int b = 0; b < game->num_bricks; b += 1) {
+		if (game->brick_handles.dead[b]) {
+			continue;
+		}
+
+		const struct brick *const brick = game->bricks[b];
+
+		double t;
+		enum collision coll;
+
+		const bool hit = collide_sweep(
+			brick->pos_x,
+			brick->pos_y,
+			brick->size_x,
+			brick->size_y,
+			ball->pos_x,
+			ball->pos_y,
+			ball->size_x,
+			ball->size_y,
+			ball->vel_x,
+			ball->vel_y,
+			&t,
+			&coll);
+
+		if (hit && t < next.time) {
+			next.type = EVSIM_BRICK;
+			next.time = t;
+			next.coll = coll;
+			next.brick = b;
+		}
+	}
+
+	if (next.time == INFINITY) {
+		// Not moving
+		return;
+	}
+
+	next.time = sim->time + fmax(next.time, 0.0);
+
+	// Send the paddle to catch a falling ball,
+	//  unless it is already going to catch one that lands sooner
+	// The ball it is going for is aimed at again every time its path
+	//  changes, e.g. when it bounces off of the side of a brick, but not
+	//  when only the paddle changed
+	if (sim->auto_paddle && ball->vel_y < 0.0) {
+		const double cross_time = sim->time
+			+ (game->paddle.pos_y + ball->size_y - ball->pos_y) / ball->vel_y;
+
+		if (cross_time >= sim->time &&
+		    (sim->auto_catch_time < sim->time ||
+		     cross_time < sim->auto_catch_time ||
+		     (bounced && i == sim->auto_catch_ball)))
+		{
+			sim->auto_catch_time = cross_time;
+			sim->auto_catch_ball = i;
+			sim->auto_catch_pending = true;
+		}
+	}
+
+	push_event(sim, next);
+}
+
+// Predict the paddle stopping and the next event for every live ball
+// Throws away all queued events first since they may all be wrong now
+static void predict_all(struct evsim *const sim) {
+	sim->num_events = 0;
+
+	for (unsigned int i = 0; i < sim->game->num_balls; i += 1) {
+		if (sim->game->ball_handles.dead[i]) {
+			continue;
+		}
+
+		advance_ball(sim, i, sim->time);
+		sim->ball_versions[i] += 1;
+		predict_ball(sim, i, false);
+	}
+
+	if (sim->paddle_vel_x != 0.0) {
+		const double x = paddle_x_at(sim, sim->time);
+
+		push_event(sim, (struct evsim_event) {
+			.time = sim->time + (sim->paddle_target_x - x) / sim->paddle_vel_x,
+			.type = EVSIM_PADDLE_STOP,
+			.coll = COLL_NONE,
+			.ball = 0,
+			.brick = 0,
+			.version = sim->paddle_version
+		});
+	}
+}
+
+// Move the paddle so that the falling ball lands on its middle
+// Wall bounces are unfolded by `predict_crossing`. Bricks are not considered,
+//  if the ball hits one `predict_ball` sends the paddle again
+static void catch_ball(struct evsim *const sim) {
+	sim->auto_catch_pending = false;
+
+	const struct game *const game = sim->game;
+	const struct ball *const ball = game->balls[sim->auto_catch_ball];
+
+	struct predict_crossing crossing;
+
+	if (!predict_crossing(game, ball, &crossing)) {
+		return;
+	}
+
+	evsim_move_paddle(
+		sim,
+		crossing.x + (ball->size_x / 2.0) - (game->paddle.size_x / 2.0),
+		sim->auto_paddle_speed);
+}
+
+// Bounce the ball off of the side of a brick or the paddle
+static void bounce(struct ball *const ball, const enum collision coll) {
+	switch (coll) {
+		case COLL_TOP:
+			ball->vel_y = fabs(ball->vel_y);
+			break;
+		case COLL_BOTTOM:
+			ball->vel_y = -fabs(ball->vel_y);
+			break;
+		case COLL_LEFT:
+			ball->vel_x = -fabs(ball->vel_x);
+			break;
+		case COLL_RIGHT:
+			ball->vel_x = fabs(ball->vel_x);
+			break;
+		case COLL_NONE:
+			break;
+	}
+}
+
+// Handle an event that is not stale
+static void handle_event(
+	struct evsim *const sim,
+	const struct evsim_event *const event)
+{
+	struct game *const game = sim->game;
+
+	if (event->type == EVSIM_PADDLE_STOP) {
+		game->paddle.pos_x = sim->paddle_target_x;
+		sim->paddle_time = sim->time;
+		sim->paddle_vel_x = 0.0;
+		sim->paddle_version += 1;
+
+		predict_all(sim);
+		return;
+	}
+
+	const unsigned int i = event->ball;
+	struct ball *const ball = game->balls[i];
+
+	advance_ball(sim, i, sim->time);
+
+	switch (event->type) {
+		case EVSIM_WALL_LEFT:
+			ball->pos_x = game->play_area_origin_x
+				- (game->play_area_size_x / 2.0);
+			ball->vel_x = fabs(ball->vel_x);
+			break;
+		case EVSIM_WALL_RIGHT:
+			ball->pos_x = game->play_area_origin_x
+				+ (game->play_area_size_x / 2.0) - ball->size_x;
+			ball->vel_x = -fabs(ball->vel_x);
+			break;
+		case EVSIM_WALL_TOP:
+			ball->pos_y = game->play_area_origin_y
+				+ (game->play_area_size_y / 2.0);
+			ball->vel_y = -fabs(ball->vel_y);
+			break;
+		case EVSIM_FLOOR:
+			game_remove_ball(game, i);
+			sim->num_live_balls -= 1;
+			sim->stats.ball_deaths += 1;
+			return;
+		case EVSIM_PADDLE:
+			bounce(ball, event->coll);
+			sim->stats.paddle_hits += 1;
+			break;
+		case EVSIM_BRICK:
+		{
+			bounce(ball, event->coll);
+
+			game_remove_brick(game, event->brick);
+			sim->num_live_bricks -= 1;
+			sim->stats.bricks_cleared += 1;
+			break;
+		}
+		case EVSIM_PADDLE_STOP:
+			break;
+	}
+
+	sim->ball_versions[i] += 1;
+	predict_ball(sim, i, true);
+}
+
+void evsim_init(struct evsim *const sim) {
+	sim->game = NULL;
+
+	sim->events_len = 64;
+	sim->events = easy_malloc(sizeof(struct evsim_event) * sim->events_len);
+	sim->num_events = 0;
+
+	sim->balls_len = 64;
+	sim->ball_times = easy_malloc(sizeof(double) * sim->balls_len);
+	sim->ball_versions = easy_malloc(sizeof(unsigned int) * sim->balls_len);
+
+	sim->auto_paddle = false;
+	sim->auto_paddle_speed = 0.0001;
+}
+
+void evsim_deinit(struct evsim *const sim) {
+	easy_free(sim->events);
+
+	easy_free(sim->ball_times);
+	easy_free(sim->ball_versions);
+}
+
+void evsim_begin(struct evsim *const sim, struct game *const game) {
+	if (!game->is_setup) {
+		fprintf(stderr, "%s: Game is not set up\n", __func__);
+
+		exit(EXIT_FAILURE);
+	}
+
+	// Everything must be alive so that the live counts are right
+	game_compact(game);
+
+	sim->game = game;
+	sim->time = 0.0;
+
+	if (sim->balls_len < game->balls_len) {
+		sim->balls_len = game->balls_len;
+		sim->ball_times = easy_realloc(
+			sim->ball_times, sizeof(double) * sim->balls_len);
+		sim->ball_versions = easy_realloc(
+			sim->ball_versions, sizeof(unsigned int) * sim->balls_len);
+	}
+
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		sim->ball_times[i] = 0.0;
+		sim->ball_versions[i] = 0;
+	}
+
+	sim->num_live_balls = game->num_balls;
+	sim->num_live_bricks = game->num_bricks;
+
+	sim->paddle_time = 0.0;
+	sim->paddle_vel_x = 0.0;
+	sim->paddle_target_x = game->paddle.pos_x;
+	sim->paddle_version = 0;
+
+	sim->auto_catch_time = -INFINITY;
+	sim->auto_catch_ball = 0;
+	sim->auto_catch_pending = false;
+
+	sim->stats = (struct evsim_stats) {0};
+
+	predict_all(sim);
+
+	if (sim->auto_catch_pending) {
+		catch_ball(sim);
+	}
+}
+
+enum evsim_result evsim_run_until(struct evsim *const sim, const double time) {
+	while (true) {
+		if (sim->num_live_bricks == 0) {
+			return EVSIM_LEVEL_CLEARED;
+		}
+
+		if (sim->num_live_balls == 0) {
+			return EVSIM_ALL_BALLS_DEAD;
+		}
+
+		if (sim->num_events == 0 || sim->events[0].time > time) {
+			sim->time = fmax(sim->time, time);
+			return EVSIM_REACHED_TIME;
+		}
+
+		const struct evsim_event event = pop_event(sim);
+
+		const bool stale = (event.type == EVSIM_PADDLE_STOP)
+			? event.version != sim->paddle_version
+			: sim->game->ball_handles.dead[event.ball] ||
+			  event.version != sim->ball_versions[event.ball];
+
+		if (stale) {
+			sim->stats.num_stale_events += 1;
+			continue;
+		}
+
+		sim->time = event.time;
+
+		if (event.type == EVSIM_BRICK &&
+		    sim->game->brick_handles.dead[event.brick])
+		{
+			// Another ball got there first so this ball keeps going
+			advance_ball(sim, event.ball, sim->time);
+			predict_ball(sim, event.ball, false);
+
+			sim->stats.num_stale_events += 1;
+			continue;
+		}
+		sim->stats.num_events += 1;
+
+		handle_event(sim, &event);
+
+		if (sim->auto_catch_pending) {
+			catch_ball(sim);
+		}
+	}
+}
+
+void evsim_move_paddle(
+	struct evsim *const sim,
+	const double target_x,
+	const double speed)
+{
+	struct game *const game = sim->game;
+
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_right = game->play_area_origin_x
+		+ (game->play_area_size_x / 2.0);
+
+	const double x = paddle_x_at(sim, sim->time);
+	double target = target_x;
+
+	if (target < play_area_left) {
+		target = play_area_left;
+	}
+	else if (target > play_area_right - game->paddle.size_x) {
+		target = play_area_right - game->paddle.size_x;
+	}
+
+	game->paddle.pos_x = x;
+	sim->paddle_time = sim->time;
+	sim->paddle_target_x = target;
+
+	if (target > x) {
+		sim->paddle_vel_x = speed;
+	}
+	else if (target < x) {
+		sim->paddle_vel_x = -speed;
+	}
+	else {
+		sim->paddle_vel_x = 0.0;
+	}
+
+	sim->paddle_version += 1;
+
+	predict_all(sim);
+}
+
+void evsim_end(struct evsim *const sim) {
+	struct game *const game = sim->game;
+
+	game->paddle.pos_x = paddle_x_at(sim, sim->time);
+	sim->paddle_time = sim->time;
+
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		advance_ball(sim, i, sim->time);
+	}
+
+	game_compact(game);
+
+	sim->game = NULL;
+}
@@ -0,0 +1,126 @@
+#ifndef EVSIM_H
+#define EVSIM_H
+
+// Event-driven simulation for fast-forwarding a game with nothing drawn
+// Instead of stepping every frame, the time at which each ball next hits
+//  a wall, the floor, the paddle, or a brick is predicted.
+// Those events go in a priority queue and the simulation jumps straight
+//  from one event to the next.
+// Not simulated: particles, camera shake, and ball-ball collisions.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "collide.h"
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum evsim_event_type {
+	EVSIM_WALL_LEFT = 0,
+	EVSIM_WALL_RIGHT,
+	EVSIM_WALL_TOP,
+	EVSIM_FLOOR,// Ball dies
+	EVSIM_PADDLE,
+	EVSIM_BRICK,
+	EVSIM_PADDLE_STOP// Paddle reached its target
+};
+
+struct evsim_event {
+	double time;// Nanoseconds since `evsim_begin`
+	enum evsim_event_type type;
+	enum collision coll;// Side of the paddle/brick that the ball hits
+	unsigned int ball;
+	unsigned int brick;
+	// Value of the ball's version (or `paddle_version` for
+	//  EVSIM_PADDLE_STOP) when predicted. Stale if it has changed
+	unsigned int version;
+};
+
+struct evsim_stats {
+	uint64_t num_events;// Events handled (not counting stale ones)
+	uint64_t num_stale_events;
+	unsigned int bricks_cleared;
+	unsigned int ball_deaths;
+	unsigned int paddle_hits;
+};
+
+enum evsim_result {
+	EVSIM_REACHED_TIME = 0,
+	EVSIM_LEVEL_CLEARED,
+	EVSIM_ALL_BALLS_DEAD
+};
+
+// While between `evsim_begin` and `evsim_end`, the sim owns the game:
+//  ball positions in the game are stale and bricks/balls are only
+//  marked dead (see `game_compact`), so do not modify the game directly
+struct evsim {
+	struct game *game;
+
+	double time;// Nanoseconds since `evsim_begin`
+
+	// Binary min-heap ordered by time
+	unsigned int events_len;
+	struct evsim_event *events;
+	unsigned int num_events;
+
+	// Per ball. Length is `balls_len`
+	unsigned int balls_len;
+	double *ball_times;// Time at which the ball's `pos_` values are current
+	unsigned int *ball_versions;// Bumped every time a ball's path changes
+
+	unsigned int num_live_balls;
+	unsigned int num_live_bricks;
+
+	// The paddle moves from `paddle.pos_x` (at time `paddle_time`)
+	//  with velocity `paddle_vel_x` until it reaches `paddle_target_x`
+	double paddle_time;
+	double paddle_vel_x;
+	double paddle_target_x;
+	unsigned int paddle_version;
+
+	// If true, whenever a ball starts falling the paddle is sent to where
+	//  it will come down, at `auto_paddle_speed` (units/ns)
+	bool auto_paddle;
+	double auto_paddle_speed;
+	// Time the ball being caught reaches the top of the paddle
+	double auto_catch_time;
+	unsigned int auto_catch_ball;
+	bool auto_catch_pending;// Paddle needs to be sent after this event
+
+	struct evsim_stats stats;
+};
+
+// Allocate buffers. Call once
+void evsim_init(struct evsim *const sim);
+
+// Free buffers
+void evsim_deinit(struct evsim *const sim);
+
+// Start simulating `game` from its current state at time 0
+// The game must be set up
+void evsim_begin(struct evsim *const sim, struct game *const game);
+
+// Handle events until the sim reaches `time`,
+//  the level is cleared, or all balls are dead
+enum evsim_result evsim_run_until(struct evsim *const sim, const double time);
+
+// Send the paddle towards `target_x` (left edge) at `speed` units/ns
+// `target_x` is clamped to the play area
+void evsim_move_paddle(
+	struct evsim *const sim,
+	const double target_x,
+	const double speed);
+
+// Write the state at the sim's current time back into the game:
+//  move balls and the paddle, and compact away dead balls and bricks
+// The sim must be begun again before running more
+void evsim_end(struct evsim *const sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,49 +1,87 @@
 #include "game.h"
 
+#include <limits.h>
+
 #include <SDL2/SDL_image.h>
 
+#include "brick_grid.h"
 #include "easy_alloc.h"
+#include "handle.h"
 #include "rand.h"
 #include "sdlu.h"
+#include "sweep.h"
+
+static const char *const brick_tex_paths[GAME_NUM_BRICK_TEXS] = {
+	"./assets/bark.jpg",
+	"./assets/brush.png",
+	"./assets/mossy.jpg",
+	"./assets/pasta.jpg",
+	"./assets/weeds.png"
+};
+
+void game_textures_init(
+	struct game_textures *const textures,
+	SDL_Renderer *renderer)
+{
+	for (unsigned int i = 0; i < GAME_NUM_BRICK_TEXS; i += 1) {
+		SDL_Surface *const surf = IMG_Load(brick_tex_paths[i]);
+		textures->brick_num_mips[i] =
+			mip_create_textures(renderer, surf, textures->brick_mips[i]);
+		SDL_FreeSurface(surf);
 
-void game_init(struct game *const game, SDL_Renderer *renderer) {
-	game->balls_len = 64;
-	game->balls = easy_malloc(sizeof(struct ball*) * game->balls_len);
-	game->num_balls = 0;
+		uint32_t format;
+		int access;
+		sdlu_query_texture(textures->brick_mips[i][0], &format, &access,
+			&textures->brick_ws[i], &textures->brick_hs[i]);
+	}
 
-	game->brick_texs_len = 10;
-	game->brick_texs = easy_malloc(
-		sizeof(SDL_Texture*) * game->brick_texs_len);
-	game->num_brick_texs = 0;
-
-	const char* brick_tex_paths[] = {
-		"./assets/bark.jpg",
-		"./assets/brush.png",
-		"./assets/mossy.jpg",
-		"./assets/pasta.jpg",
-		"./assets/weeds.png",
-		NULL};
-
-	while (game->num_brick_texs < game->brick_texs_len &&
-		   brick_tex_paths[game->num_brick_texs] != NULL) {
-		SDL_Surface *const surf =
-			IMG_Load(brick_tex_paths[game->num_brick_texs]);
-		SDL_Texture *tex = sdlu_create_texture_from_surface(
-			renderer, surf);
-		SDL_FreeSurface(surf);
+	SDL_Surface *const cat_surf = IMG_Load("./assets/cat.png");
+	textures->ball = sdlu_create_texture_from_surface(renderer, cat_surf);
+	SDL_FreeSurface(cat_surf);
+}
 
-		game->brick_texs[game->num_brick_texs] = tex;
-		game->num_brick_texs += 1;
+void game_textures_deinit(struct game_textures *const textures) {
+	for (unsigned int i = 0; i < GAME_NUM_BRICK_TEXS; i += 1) {
+		for (unsigned int level = 0; level < textures->brick_num_mips[i];
+			level += 1)
+		{
+			SDL_DestroyTexture(textures->brick_mips[i][level]);
+		}
 	}
 
+	SDL_DestroyTexture(textures->ball);
+}
+
+void game_init(struct game *const game) {
+	game->balls_len = 64;
+	game->balls = easy_malloc(sizeof(struct ball*) * game->balls_len);
+	game->ball_order = easy_malloc(sizeof(unsigned int) * game->balls_len);
+	game->ball_boxes = easy_malloc(
+		sizeof(struct sweep_box) * game->balls_len);
+	game->ball_contacts = easy_malloc(
+		sizeof(struct ball_contact) * game->balls_len);
+	handle_table_init(&game->ball_handles);
+	game->num_balls = 0;
+
 	game->bricks_len = 128;
 	game->bricks = easy_malloc(sizeof(struct brick*) * game->bricks_len);
+	game->brick_claims = easy_malloc(sizeof(unsigned int) * game->bricks_len);
+	handle_table_init(&game->brick_handles);
+	collide_boxes_init(&game->brick_boxes);
+	rect_hash_init(&game->brick_hash, GAME_BRICK_CELL_SIZE);
+	game->brick_hash_handles = easy_malloc(
+		sizeof(struct handle) * game->bricks_len);
+	game->bricks_hashed = true;
 	game->num_bricks = 0;
 
-	game->particles_len = 16384;
-	game->particles = easy_malloc(
-		sizeof(struct particle*) * game->particles_len);
-	game->num_particles = 0;
+	// Grows when a ball dies (400 particles). Kept small so that
+	//  many games can run at once
+	particles_init(&game->particles, 1024, GAME_PARTICLE_LIFETIME_NS);
+	game->particle_collisions = false;
+	rect_hash_init(&game->rect_hash, GAME_PARTICLE_CELL_SIZE);
+
+	// Room for a few hundred bricks before another chunk is needed
+	easy_arena_init(&game->level_arena, 64 * 1024);
 
 	game->paddle.pos_x = -300.0;
 	game->paddle.pos_y = -1700.0;
@@ -60,6 +98,8 @@ void game_init(struct game *const game, SDL_Renderer *renderer) {
 	game->camera_spring_constant = 0.0001;
 	game->camera_vel_x = 0.0;
 	game->camera_vel_y = 0.0;
+	game->camera_time_ns = 0;
+	game->brick_scroll_ns = 0;
 
 	game->play_area_origin_x = 0.0;
 	game->play_area_origin_y = 0.0;
@@ -68,24 +108,103 @@ void game_init(struct game *const game, SDL_Renderer *renderer) {
 
 	game->is_setup = false;
 
-	SDL_Surface *const cat_surf = IMG_Load("./assets/cat.png");
-	game->ball_tex = sdlu_create_texture_from_surface(renderer, cat_surf);
-	SDL_FreeSurface(cat_surf);
+	game->parallel = true;
+
+	rand_state_seed(&game->rand, 0);
+}
+
+void game_seed(struct game *const game, const uint64_t seed) {
+	rand_state_seed(&game->rand, seed);
 }
 
 void game_deinit(struct game *const game) {
-	free(game->balls);
+	easy_free(game->balls);
+	easy_free(game->ball_order);
+	easy_free(game->ball_boxes);
+	easy_free(game->ball_contacts);
+	handle_table_deinit(&game->ball_handles);
+
+	easy_free(game->bricks);
+	easy_free(game->brick_claims);
+	handle_table_deinit(&game->brick_handles);
+	collide_boxes_deinit(&game->brick_boxes);
+	rect_hash_deinit(&game->brick_hash);
+	easy_free(game->brick_hash_handles);
+
+	particles_deinit(&game->particles);
+	rect_hash_deinit(&game->rect_hash);
+
+	easy_arena_deinit(&game->level_arena);
+}
+
+// Columns and rows of bricks that `game_setup` fits in the play area
+//  for bricks of the given size
+static void count_brick_cells(
+	const struct game *const game,
+	const double brick_size_x,
+	const double brick_size_y,
+	unsigned int *const num_columns,
+	unsigned int *const num_rows)
+{
+	const double max_y = game->play_area_origin_y + game->play_area_size_y * 0.45;
+	const double min_y = game->play_area_origin_y
+		- game->play_area_size_y * 0.12
+		+ brick_size_y;
+
+	const double max_x = game->play_area_origin_x
+		+ game->play_area_size_x * 0.45
+		- (brick_size_x + 2.0 * GAME_BRICK_MARGIN_X);
+
+	const int half_num_columns = max_x / (brick_size_x + 2.0 * GAME_BRICK_MARGIN_X);
+	*num_columns = 2 * half_num_columns + 2;
 
-	for (unsigned int i = 0; i < game->num_brick_texs; i += 1) {
-		SDL_DestroyTexture(game->brick_texs[i]);
+	const double pitch_y = brick_size_y + 2.0 * GAME_BRICK_MARGIN_Y;
+
+	*num_rows = 0;
+	for (double y = max_y; y > min_y; y -= pitch_y) {
+		*num_rows += 1;
+	}
+}
+
+// Make the brick buffers at least `len` long
+static void grow_bricks(struct game *const game, const unsigned int len) {
+	if (len <= game->bricks_len) {
+		return;
+	}
+
+	while (len > game->bricks_len) {
+		game->bricks_len = game->bricks_len * 2;
 	}
-	free(game->brick_texs);
 
-	free(game->bricks);
+	game->bricks = easy_realloc(
+		game->bricks, sizeof(struct ball*) * game->bricks_len);
+	game->brick_claims = easy_realloc(
+		game->brick_claims, sizeof(unsigned int) * game->bricks_len);
+	game->brick_hash_handles = easy_realloc(game->brick_hash_handles,
+		sizeof(struct handle) * game->bricks_len);
+}
+
+// Build `game.brick_hash` from the bricks
+static void hash_bricks(struct game *const game) {
+	struct rect_hash *const hash = &game->brick_hash;
+	rect_hash_resize(hash, game->num_bricks);
+
+	for (unsigned int b = 0; b < game->num_bricks; b += 1) {
+		const struct brick *const brick = game->bricks[b];
 
-	free(game->particles);
+		hash->rects[b] = (struct rect_hash_rect) {
+			.pos_x = brick->pos_x,
+			.pos_y = brick->pos_y,
+			.size_x = brick->size_x,
+			.size_y = brick->size_y
+		};
 
-	SDL_DestroyTexture(game->ball_tex);
+		game->brick_hash_handles[b] =
+			handle_table_get(&game->brick_handles, b);
+	}
+
+	rect_hash_build(hash);
+	game->bricks_hashed = true;
 }
 
 void game_setup(struct game *const game) {
@@ -97,7 +216,7 @@ void game_setup(struct game *const game) {
 
 	game->num_bricks = 0;
 	game->num_balls = 0;
-	game->num_particles = 0;
+	particles_clear(&game->particles);
 
 	// Center the camera
 	game->viewport_center_x = game->play_area_origin_x;
@@ -105,84 +224,108 @@ void game_setup(struct game *const game) {
 
 	game->camera_vel_x = 0.0;
 	game->camera_vel_y = 0.0;
+	game->camera_time_ns = 0;
+	game->brick_scroll_ns = 0;
+
+	// Make room for the largest level, with the smallest bricks and no
+	//  skipped rows, so that only the first setup of a play area allocates
+	{
+		unsigned int max_columns;
+		unsigned int max_rows;
+		count_brick_cells(game, GAME_MIN_BRICK_SIZE_X, GAME_MIN_BRICK_SIZE_Y,
+			&max_columns, &max_rows);
+
+		const unsigned int max_bricks = max_columns * max_rows;
+		const size_t max_size = sizeof(struct brick) > sizeof(struct ball)
+			? sizeof(struct brick)
+			: sizeof(struct ball);
+
+		easy_arena_reserve(&game->level_arena, max_bricks + 1, max_size);
+		grow_bricks(game, max_bricks);
+		collide_boxes_reserve(&game->brick_boxes, max_bricks);
+		handle_table_reserve(&game->brick_handles, max_bricks);
+		rect_hash_reserve(&game->brick_hash, max_bricks,
+			GAME_MAX_BRICK_SIZE_X, GAME_MAX_BRICK_SIZE_Y);
+		// And the paddle
+		rect_hash_reserve(&game->rect_hash, max_bricks + 1,
+			fmax(GAME_MAX_BRICK_SIZE_X, game->paddle.size_x),
+			fmax(GAME_MAX_BRICK_SIZE_Y, game->paddle.size_y));
+	}
 
 	// Make bricks
 
-	const double brick_size_x = 360.0 + rand_double(0.0, 50.0);
-	const double brick_size_y = 170.0 + rand_double(0.0, 50.0);
+	const double brick_size_x = GAME_MIN_BRICK_SIZE_X + rand_state_double(
+		&game->rand, 0.0, GAME_MAX_BRICK_SIZE_X - GAME_MIN_BRICK_SIZE_X);
+	const double brick_size_y = GAME_MIN_BRICK_SIZE_Y + rand_state_double(
+		&game->rand, 0.0, GAME_MAX_BRICK_SIZE_Y - GAME_MIN_BRICK_SIZE_Y);
 
 	const double max_y = game->play_area_origin_y + game->play_area_size_y * 0.45;
-	const double min_y = game->play_area_origin_y
-		- game->play_area_size_y * 0.12
-		+ brick_size_y;
 
-	const double brick_margin_x = 10.0;
-	const double brick_margin_y = 10.0;
+	const double pitch_x = brick_size_x + 2.0 * GAME_BRICK_MARGIN_X;
+	const double pitch_y = brick_size_y + 2.0 * GAME_BRICK_MARGIN_Y;
 
-	const double max_x = game->play_area_origin_x
-		+ game->play_area_size_x * 0.45
-		- (brick_size_x + 2.0 * brick_margin_x);
+	unsigned int num_columns;
+	unsigned int num_rows;
+	count_brick_cells(game, brick_size_x, brick_size_y,
+		&num_columns, &num_rows);
 
-	const int half_num_columns = max_x / (brick_size_x + 2.0 * brick_margin_x);
+	const double left_x = -(double)(num_columns / 2) * pitch_x;
 
 	// Create bricks
-	for (double y = max_y; y > min_y;
-		 y -= brick_size_y + 2.0 * brick_margin_y)
-	{
+	// Not through a `brick_grid`, which would stop about a quarter of them
+	//  from scrolling (see `brick_grid_set`)
+	for (unsigned int row = 0; row < num_rows; row += 1) {
 		// Maybe skip a row
-		if (rand() < (RAND_MAX * 0.3)) {
+		if (rand_state_double01(&game->rand) < 0.3) {
 			continue;
 		}
 
-		 for (double x = -(half_num_columns + 1)
-		                 * (brick_size_x + 2.0 * brick_margin_x);
-		      x <= half_num_columns * (brick_size_x + 2.0 * brick_margin_x)
-		           + 1.0 /* +1 because floating point inaccuracy */;
-		      x += brick_size_x + 2.0 * brick_margin_x)
-		{
-			struct brick *brick = easy_malloc(sizeof(struct brick));
+		for (unsigned int column = 0; column < num_columns; column += 1) {
+			struct brick *const brick = game_new_brick(game);
 
 			*brick = (struct brick) {
-				.pos_x = x + brick_margin_x,
-				.pos_y = y - brick_margin_y,
+				.pos_x = left_x + column * pitch_x + GAME_BRICK_MARGIN_X,
+				.pos_y = max_y - row * pitch_y - GAME_BRICK_MARGIN_Y,
 				.size_x = brick_size_x,
 				.size_y = brick_size_y
 			};
 
-			const int tex_index = rand() % game->num_brick_texs;
-			// printf("tex_index: %d\n", tex_index);
-			brick->inner_tex = game->brick_texs[tex_index];
+			brick->inner_tex_index =
+				rand_state_next(&game->rand) % GAME_NUM_BRICK_TEXS;
 
-			brick->inner_tex_x_prop = rand_double01();
-			brick->inner_tex_y_prop = rand_double01();
+			brick->inner_tex_x_prop = rand_state_double01(&game->rand);
+			brick->inner_tex_y_prop = rand_state_double01(&game->rand);
 
-			brick->inner_tex_w = rand_int(200, 400);
+			brick->inner_tex_w = rand_state_int(&game->rand, 200, 400);
 			brick->inner_tex_h =
 				brick->inner_tex_w * brick->size_y / brick->size_x;
 
 			brick->inner_tex_x_prop_speed =
-				rand_double01() * rand_double01() * rand_double(-1.0, 1.0)
+				rand_state_double01(&game->rand)
+				* rand_state_double01(&game->rand)
+				* rand_state_double(&game->rand, -1.0, 1.0)
 				* 0.0000000009;
 			brick->inner_tex_y_prop_speed =
-				rand_double01() * rand_double01() * rand_double(-1.0, 1.0)
+				rand_state_double01(&game->rand)
+				* rand_state_double01(&game->rand)
+				* rand_state_double(&game->rand, -1.0, 1.0)
 				* 0.0000000009;
 
 			game_append_brick(game, brick);
-
-			// printf("num_bricks: %d\n", game->num_bricks);
 		}
 	}
 
+	hash_bricks(game);
+
 	// Create ball
-	struct ball *ball = easy_malloc(sizeof(struct ball));
+	struct ball *ball = game_new_ball(game);
 	*ball = (struct ball) {
 		.pos_x = 0.0,
 		.pos_y = -1300.0,
 		.vel_x =  0.000002,
 		.vel_y =  0.000003,
 		.size_x = 137.9257,
-		.size_y = 300.0,
-		.tex = game->ball_tex
+		.size_y = 300.0
 	};
 
 	game_append_ball(game, ball);
@@ -195,27 +338,35 @@ void game_desetup(struct game *const game) {
 
 	game->is_setup = false;
 
-	// Free bricks
-	for (unsigned int i = 0; i < game->num_bricks; i += 1) {
-		free(game->bricks[i]);
-	}
+	// Frees every ball and brick, including the dead ones
+	easy_arena_reset(&game->level_arena);
 
-	// Free balls
-	for (unsigned int i = 0; i < game->num_balls; i += 1) {
-		free(game->balls[i]);
-	}
+	handle_table_clear(&game->ball_handles);
+	handle_table_clear(&game->brick_handles);
+}
 
-	// Free particles
-	for (unsigned int i = 0; i < game->num_particles; i += 1) {
-		free(game->particles[i]);
-	}
+struct ball *game_new_ball(struct game *const game) {
+	return easy_arena_alloc(&game->level_arena, sizeof(struct ball));
 }
 
-void game_append_ball(struct game *const game, struct ball *const ball) {
+struct brick *game_new_brick(struct game *const game) {
+	return easy_arena_alloc(&game->level_arena, sizeof(struct brick));
+}
+
+struct handle game_append_ball(
+	struct game *const game,
+	struct ball *const ball)
+{
 	if (game->num_balls == game->balls_len) {
 		game->balls_len = game->balls_len * 2;
 		game->balls = easy_realloc(
 			game->balls, sizeof(struct ball*) * game->balls_len);
+		game->ball_order = easy_realloc(
+			game->ball_order, sizeof(unsigned int) * game->balls_len);
+		game->ball_boxes = easy_realloc(
+			game->ball_boxes, sizeof(struct sweep_box) * game->balls_len);
+		game->ball_contacts = easy_realloc(game->ball_contacts,
+			sizeof(struct ball_contact) * game->balls_len);
 	}
 	else if (game->num_balls > game->balls_len) {
 		fprintf(stderr, "%s: Buffer overflow detected "
@@ -226,37 +377,38 @@ void game_append_ball(struct game *const game, struct ball *const ball) {
 	}
 
 	game->balls[game->num_balls] = ball;
+	// New balls go at the end of the order. The next sort moves them into place
+	game->ball_order[game->num_balls] = game->num_balls;
 	game->num_balls += 1;
+
+	return handle_table_add(&game->ball_handles, game->num_balls - 1);
 }
 
-void game_append_particle(
+void game_append_brick_grid(
 	struct game *const game,
-	struct particle *const particle)
+	const struct brick_grid *const grid)
 {
-	if (game->num_particles == game->particles_len) {
-		game->particles_len = game->particles_len * 2;
-		game->particles = easy_realloc(
-			game->particles, sizeof(struct particle*) * game->particles_len);
-	}
-	else if (game->num_particles > game->particles_len) {
-		fprintf(stderr, "%s: Buffer overflow detected "
-			"[num_particles: %d] [particles_len: %d]",
-			__func__, game->num_particles, game->particles_len);
+	const unsigned int num_cells = brick_grid_num_cells(grid);
 
-		exit(EXIT_FAILURE);
+	for (unsigned int i = 0; i < num_cells; i += 1) {
+		if (!brick_grid_has(grid, i)) {
+			continue;
+		}
+
+		struct brick *const brick = game_new_brick(game);
+		brick_grid_get(grid, i, brick);
+
+		game_append_brick(game, brick);
 	}
 
-	game->particles[game->num_particles] = particle;
-	game->num_particles += 1;
+	hash_bricks(game);
 }
 
-void game_append_brick(struct game *const game, struct brick *const brick) {
-	if (game->num_bricks == game->bricks_len) {
-		game->bricks_len = game->bricks_len * 2;
-		game->bricks = easy_realloc(
-			game->bricks, sizeof(struct ball*) * game->bricks_len);
-	}
-	else if (game->num_bricks > game->bricks_len) {
+struct handle game_append_brick(
+	struct game *const game,
+	struct brick *const brick)
+{
+	if (game->num_bricks > game->bricks_len) {
 		fprintf(stderr, "%s: Buffer overflow detected "
 			"[num_bricks: %d] [bricks_len: %d]",
 			__func__, game->num_bricks, game->bricks_len);
@@ -264,8 +416,18 @@ void game_append_brick(struct game *const game, struct brick *const brick) {
 		exit(EXIT_FAILURE);
 	}
 
+	grow_bricks(game, game->num_bricks + 1);
+
 	game->bricks[game->num_bricks] = brick;
 	game->num_bricks += 1;
+
+	collide_boxes_resize(&game->brick_boxes, game->num_bricks);
+	collide_boxes_set(&game->brick_boxes, game->num_bricks - 1,
+		brick->pos_x, brick->pos_y, brick->size_x, brick->size_y);
+
+	game->bricks_hashed = false;
+
+	return handle_table_add(&game->brick_handles, game->num_bricks - 1);
 }
 
 void game_remove_ball(struct game *const game, const unsigned int i) {
@@ -276,49 +438,696 @@ void game_remove_ball(struct game *const game, const unsigned int i) {
 		exit(EXIT_FAILURE);
 	}
 
-	free(game->balls[i]);
+	game->ball_handles.dead[i] = true;
+}
+
+void game_remove_brick(struct game *const game, const unsigned int i) {
+	if (i >= game->num_bricks) {
+		fprintf(stderr, "%s: Brick index too high. "
+			"[i: %d] [num_bricks: %d]\n",
+			__func__, i, game->num_bricks);
 
-	if (game->num_balls > 1) {
-		game->balls[i] = game->balls[game->num_balls - 1];
+		exit(EXIT_FAILURE);
 	}
 
-	game->num_balls -= 1;
+	game->brick_handles.dead[i] = true;
 }
 
-void game_remove_particle(struct game *const game, const unsigned int i) {
-	if (i >= game->num_particles) {
-		fprintf(stderr, "%s: Particle index too high. "
-			"[i: %d] [num_particles: %d]\n",
-			__func__, i, game->num_particles);
+void game_compact(struct game *const game) {
+	struct handle_table *const ball_handles = &game->ball_handles;
 
-		exit(EXIT_FAILURE);
+	// Keep the sweep order valid without re-sorting:
+	//  drop dead balls and remember the rest by slot while they move
+	unsigned int num_order = 0;
+
+	for (unsigned int k = 0; k < game->num_balls; k += 1) {
+		const unsigned int index = game->ball_order[k];
+
+		if (!ball_handles->dead[index]) {
+			game->ball_order[num_order] = ball_handles->slots[index];
+			num_order += 1;
+		}
 	}
 
-	free(game->particles[i]);
+	game->num_balls = handle_table_compact(
+		ball_handles, (void**)game->balls, game->num_balls);
 
-	if (game->num_particles > 1) {
-		game->particles[i] = game->particles[game->num_particles - 1];
+	for (unsigned int k = 0; k < num_order; k += 1) {
+		game->ball_order[k] = ball_handles->indices[game->ball_order[k]];
 	}
 
-	game->num_particles -= 1;
+	const unsigned int old_num_bricks = game->num_bricks;
+
+	game->num_bricks = handle_table_compact(
+		&game->brick_handles, (void**)game->bricks, game->num_bricks);
+
+	if (game->num_bricks != old_num_bricks) {
+		collide_boxes_resize(&game->brick_boxes, game->num_bricks);
+
+		for (unsigned int i = 0; i < game->num_bricks; i += 1) {
+			const struct brick *const brick = game->bricks[i];
+
+			collide_boxes_set(&game->brick_boxes, i,
+				brick->pos_x, brick->pos_y, brick->size_x, brick->size_y);
+		}
+	}
 }
 
-void game_remove_brick(struct game *const game, const unsigned int i) {
-	if (i >= game->num_bricks) {
-		fprintf(stderr, "%s: Brick index too high. "
-			"[i: %d] [num_bricks: %d]\n",
-			__func__, i, game->num_bricks);
+struct ball *game_get_ball(
+	const struct game *const game,
+	const struct handle handle)
+{
+	const unsigned int i = handle_table_lookup(&game->ball_handles, handle);
 
-		exit(EXIT_FAILURE);
+	return (i == UINT_MAX) ? NULL : game->balls[i];
+}
+
+struct brick *game_get_brick(
+	const struct game *const game,
+	const struct handle handle)
+{
+	const unsigned int i = handle_table_lookup(&game->brick_handles, handle);
+
+	return (i == UINT_MAX) ? NULL : game->bricks[i];
+}
+
+// Populate the `out_` values as a random rect inside the given rect
+static void rand_rect_inside_rect(
+	struct rand_state *const state,
+	const double pos_x,
+	const double pos_y,
+	const double size_x,
+	const double size_y,
+	game_scalar *const out_pos_x,
+	game_scalar *const out_pos_y,
+	game_scalar *const out_size_x,
+	game_scalar *const out_size_y)
+{
+	// Arbitrarily decided that the rect is [0.05, 0.95] of the parent sizes
+	*out_size_x = rand_state_double(state, 0.05 * size_x, 0.95 * size_x);
+	*out_size_y = rand_state_double(state, 0.05 * size_y, 0.95 * size_y);
+
+	const double parent_right = pos_x + size_x;
+	const double parent_bottom = pos_y - size_y;
+
+	*out_pos_x = rand_state_double(state, pos_x, parent_right - *out_size_x);
+	*out_pos_y = rand_state_double(state, parent_bottom + *out_size_y, pos_y);
+}
+
+// Move the ball and bounce it off of the walls and the paddle
+// Spawns particles if the ball dies
+// Must run serially because it moves the camera and uses the game's `rand`
+static void update_ball_serial(
+	struct game *const game,
+	struct ball *const ball,
+	struct ball_contact *const contact,
+	const game_scalar sdelta,
+	const double paddle_dx)
+{
+	ball->pos_x += ball->vel_x * sdelta;
+	ball->pos_y += ball->vel_y * sdelta;
+
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_right = game->play_area_origin_x
+		+ (game->play_area_size_x / 2.0);
+
+	const double play_area_top = game->play_area_origin_y
+		+ (game->play_area_size_y / 2.0);
+
+	const double play_area_bottom = game->play_area_origin_y
+		- (game->play_area_size_y / 2.0);
+
+	const double ball_right = ball->pos_x + ball->size_x;
+	const double ball_bottom = ball->pos_y - ball->size_y;
+
+	// Camera shake
+	const double bump_distance = 20.0;
+
+	// Bounce off the walls and ceiling
+	if (ball->pos_x < play_area_left) {
+		ball->pos_x = play_area_left;
+		ball->vel_x = -ball->vel_x;
+
+		game->viewport_center_x += bump_distance;
+	}
+
+	if (ball_right > play_area_right) {
+		ball->pos_x = play_area_right - ball->size_x;
+		ball->vel_x = -ball->vel_x;
+
+		game->viewport_center_x -= bump_distance;
 	}
 
-	free(game->bricks[i]);
+	if (ball->pos_y > play_area_top) {
+		ball->pos_y = play_area_top;
+		ball->vel_y = -ball->vel_y;
 
-	if (game->num_bricks > 1) {
-		game->bricks[i] = game->bricks[game->num_bricks - 1];
+		game->viewport_center_y -= bump_distance;
 	}
 
-	game->num_bricks -= 1;
+	if (ball_bottom < play_area_bottom) {
+		// Ball dies
+
+		contact->remove_ball = true;
+
+		// Spawn particles
+		for (int p = 0; p < 400; p +=1 ) {
+			struct particle *particle = particles_spawn(&game->particles);
+
+			rand_rect_inside_rect(
+				&game->rand,
+				ball->pos_x, ball->pos_y,
+				ball->size_x, ball->size_y,
+				&particle->pos_x,
+				&particle->pos_y,
+				&particle->size_x,
+				&particle->size_y);
+
+			particle->vel_x = rand_state_double(&game->rand, -0.000008, 0.000008);
+			particle->vel_y = rand_state_double(&game->rand, 0.000008, 0.000020);
+
+			particle->r = rand_state_int(&game->rand, 0, 255);
+			particle->g = rand_state_int(&game->rand, 0, 255);
+			particle->b = rand_state_int(&game->rand, 0, 255);
+			particle->a = rand_state_int(&game->rand, 0, 255);
+		}
+	}
+
+	// Check collision with paddle
+
+	enum collision coll = collide_rects(
+		game->paddle.pos_x,
+		game->paddle.pos_y,
+		game->paddle.size_x,
+		game->paddle.size_y,
+		ball->pos_x,
+		ball->pos_y,
+		ball->size_x,
+		ball->size_y);
+
+	if (coll == COLL_NONE) {
+		return;
+	}
+
+	contact->hit_paddle = true;
+
+	// At 0.0 because is buggy and makes ball fly super fast
+	const double paddle_additive_speed_mult = 0.0;
+
+	const double diff_x = paddle_dx / sdelta * paddle_additive_speed_mult;
+
+	// Maybe a switch should be used here
+
+	// If bouncing off the top
+	if (coll == COLL_TOP) {
+		ball->pos_y = game->paddle.pos_y + ball->size_y;
+
+		ball->vel_y = -ball->vel_y;
+		ball->vel_x += diff_x;
+	}
+
+	// diff_x should not be added if the ball and paddle
+	//  are moving in the same direction
+	//  at time of collision (is this correct? why?)
+	//  but close enough
+
+	// If hit left side
+	if (coll == COLL_LEFT) {
+		ball->pos_x = game->paddle.pos_x - ball->size_x;
+
+		ball->vel_x = -ball->vel_x + diff_x;
+	}
+	else if (coll == COLL_RIGHT) {
+		ball->pos_x = game->paddle.pos_x + game->paddle.size_x;
+
+		ball->vel_x = -ball->vel_x + diff_x;
+	}
+}
+
+// Find the first brick (by index) that the ball collides with
+// Only reads the bricks so it can run for all balls in parallel
+// Tests COLLIDE_LANES bricks at a time. Same result as `collide_rects`
+//  with each brick in turn
+static void find_brick_contact(
+	const struct game *const game,
+	const struct ball *const ball,
+	struct ball_contact *const contact,
+	const game_scalar sdelta)
+{
+	const bool *const brick_dead = game->brick_handles.dead;
+
+	for (unsigned int first = 0; first < game->num_bricks;
+		first += COLLIDE_LANES)
+	{
+		uint8_t colls[COLLIDE_LANES];
+
+		const unsigned int hits = collide_boxes_test(&game->brick_boxes,
+			first, ball->pos_x, ball->pos_y, ball->size_x, ball->size_y,
+			colls);
+
+		if (hits == 0) {
+			continue;
+		}
+
+		// Boxes past `num_bricks` never hit, so `b` is a brick
+		for (unsigned int k = 0; k < COLLIDE_LANES; k += 1) {
+			const unsigned int b = first + k;
+
+			if (!(hits & (1u << k)) || brick_dead[b]) {
+				continue;
+			}
+
+			const struct brick *const brick = game->bricks[b];
+
+			contact->brick = b;
+			contact->coll = colls[k];
+			contact->entry_time = collide_entry_time(
+				brick->pos_x,
+				brick->pos_y,
+				brick->size_x,
+				brick->size_y,
+				ball->pos_x,
+				ball->pos_y,
+				ball->size_x,
+				ball->size_y,
+				ball->vel_x * sdelta,
+				ball->vel_y * sdelta);
+
+			return;
+		}
+	}
+}
+
+// Bounce the ball off of the brick it hit and spawn particles
+static void resolve_brick_contact(
+	struct game *const game,
+	struct ball *const ball,
+	const struct ball_contact *const contact)
+{
+	const struct brick *const brick = game->bricks[contact->brick];
+
+	switch (contact->coll) {
+		case COLL_TOP:
+			ball->pos_y = brick->pos_y + ball->size_y;
+			ball->vel_y = -ball->vel_y;
+			break;
+		case COLL_BOTTOM:
+			ball->pos_y = brick->pos_y - brick->size_y;
+			ball->vel_y = -ball->vel_y;
+			break;
+		case COLL_LEFT:
+			ball->pos_x = brick->pos_x - ball->size_x;
+			ball->vel_x = -ball->vel_x;
+			break;
+		case COLL_RIGHT:
+			ball->pos_x = brick->pos_x + brick->size_x;
+			ball->vel_x = -ball->vel_x;
+			break;
+		case COLL_NONE:
+			break;
+	}
+
+	// Spawn particles
+	for (int p = 0; p < 10; p +=1 ) {
+		struct particle *particle = particles_spawn(&game->particles);
+
+		rand_rect_inside_rect(
+			&game->rand,
+			brick->pos_x, brick->pos_y,
+			brick->size_x, brick->size_y,
+			&particle->pos_x,
+			&particle->pos_y,
+			&particle->size_x,
+			&particle->size_y);
+
+		game_scalar base_vx = ball->vel_x * 0.7;
+		game_scalar base_vy = ball->vel_y * 0.7;
+
+		// Invert because the ball already bounced
+		//  (velocity was mirrored previously)
+		if (contact->coll == COLL_LEFT || contact->coll == COLL_RIGHT) {
+			base_vx *= -1.0;
+		}
+		else {
+			base_vy *= -1.0;
+		}
+
+		particle->vel_x = base_vx + rand_state_double(&game->rand, -0.0000012, 0.0000012);
+		particle->vel_y = base_vy + rand_state_double(&game->rand, -0.0000008, 0.0000016);
+
+		particle->r = rand_state_int(&game->rand, 0, 255);
+		particle->g = rand_state_int(&game->rand, 0, 255);
+		particle->b = rand_state_int(&game->rand, 0, 255);
+		particle->a = rand_state_int(&game->rand, 0, 255);
+	}
+}
+
+// Returns true if contact `a` happened before contact `b`
+// Ties go to the lower ball index so the result is always the same
+static bool contact_is_earlier(
+	const struct ball_contact *const a,
+	const unsigned int a_index,
+	const struct ball_contact *const b,
+	const unsigned int b_index)
+{
+	if (a->entry_time != b->entry_time) {
+		return a->entry_time < b->entry_time;
+	}
+
+	return a_index < b_index;
+}
+
+void game_update_balls(
+	struct game *const game,
+	const uint64_t delta,
+	const double paddle_dx)
+{
+	const game_scalar sdelta = (game_scalar)delta;
+	const unsigned int num_balls = game->num_balls;
+	struct ball_contact *const contacts = game->ball_contacts;
+
+	// Walls and paddle
+	for (unsigned int i = 0; i < num_balls; i += 1) {
+		contacts[i] = (struct ball_contact) {
+			.brick = UINT_MAX,
+			.coll = COLL_NONE,
+			.entry_time = 0.0,
+			.hit_paddle = false,
+			.remove_ball = false
+		};
+
+		update_ball_serial(
+			game, game->balls[i], &contacts[i], sdelta, paddle_dx);
+	}
+
+	// Phase one: find brick contacts in parallel. Bricks are not modified
+	#pragma omp parallel for schedule(static) if(game->parallel)
+	for (unsigned int i = 0; i < num_balls; i += 1) {
+		// A ball that hit the paddle does not also hit a brick
+		if (!contacts[i].hit_paddle) {
+			find_brick_contact(game, game->balls[i], &contacts[i], sdelta);
+		}
+	}
+
+	// Phase two: the earliest contact with each brick claims it
+	for (unsigned int b = 0; b < game->num_bricks; b += 1) {
+		game->brick_claims[b] = UINT_MAX;
+	}
+
+	for (unsigned int i = 0; i < num_balls; i += 1) {
+		const unsigned int b = contacts[i].brick;
+
+		if (b == UINT_MAX) {
+			continue;
+		}
+
+		const unsigned int claim = game->brick_claims[b];
+
+		if (claim == UINT_MAX ||
+		    contact_is_earlier(&contacts[i], i, &contacts[claim], claim))
+		{
+			game->brick_claims[b] = i;
+		}
+	}
+
+	// Apply claimed contacts in ball order so particles spawn the same way
+	//  every time
+	for (unsigned int i = 0; i < num_balls; i += 1) {
+		const unsigned int b = contacts[i].brick;
+
+		if (b != UINT_MAX && game->brick_claims[b] == i) {
+			resolve_brick_contact(game, game->balls[i], &contacts[i]);
+			game_remove_brick(game, b);
+		}
+
+		if (contacts[i].remove_ball) {
+			game_remove_ball(game, i);
+		}
+	}
+}
+
+unsigned int game_collide_balls(struct game *const game) {
+	sweep_sort(game->balls, game->ball_order, game->ball_boxes,
+		game->num_balls);
+
+	return sweep_collide(game->balls, game->ball_order, game->ball_boxes,
+		game->num_balls);
+}
+
+double game_move_paddle(struct game *const game, const double new_x) {
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_right = game->play_area_origin_x
+		+ (game->play_area_size_x / 2.0);
+
+	const double paddle_max_right = play_area_right - game->paddle.size_x;
+
+	double x = new_x;
+
+	if (x < play_area_left) {
+		x = play_area_left;
+	}
+	else if (x > paddle_max_right) {
+		x = paddle_max_right;
+	}
+
+	const double dx = x - game->paddle.pos_x;
+
+	game->paddle.pos_x = x;
+
+	return dx;
+}
+
+// A particle while it is tested against the rects near it
+struct particle_motion {
+	game_scalar pos_x;
+	game_scalar pos_y;
+	game_scalar size_x;
+	game_scalar size_y;
+
+	// Only worked out once the particle overlaps a rect
+	bool has_velocity;
+	game_scalar vel_x;
+	game_scalar vel_y;
+
+	bool bounced;
+};
+
+// Bounce the particle off of the rect if they overlap and the particle
+//  is moving into it. On the top it loses speed along the rect and stops
+//  bouncing once it is slow
+static void bounce_particle(
+	const struct particles *const particles,
+	const struct particle *const particle,
+	struct particle_motion *const motion,
+	const struct rect_hash_rect *const rect)
+{
+	const game_scalar x = rect->pos_x;
+	const game_scalar y = rect->pos_y;
+	const game_scalar w = rect->size_x;
+	const game_scalar h = rect->size_y;
+
+	const game_scalar size_x = motion->size_x;
+	const game_scalar size_y = motion->size_y;
+
+	// Most rects near a particle are not touching it. Leave the ones
+	//  that only touch it to `collide_rects`
+	if (motion->pos_x > x + w || motion->pos_x + size_x < x
+		|| motion->pos_y - size_y > y || motion->pos_y < y - h)
+	{
+		return;
+	}
+
+	const enum collision coll = collide_rects(x, y, w, h,
+		motion->pos_x, motion->pos_y, size_x, size_y);
+
+	if (coll == COLL_NONE) {
+		return;
+	}
+
+	if (!motion->has_velocity) {
+		particles_velocity(particles, particle,
+			&motion->vel_x, &motion->vel_y);
+		motion->has_velocity = true;
+	}
+
+	switch (coll) {
+		case COLL_TOP:
+			if (motion->vel_y >= 0.0) return;
+
+			motion->pos_y = y + size_y;
+			motion->vel_y = -motion->vel_y * GAME_PARTICLE_BOUNCE;
+			motion->vel_x *= GAME_PARTICLE_FRICTION;
+
+			if (motion->vel_y < GAME_PARTICLE_SETTLE_SPEED) {
+				motion->vel_y = 0.0;
+			}
+			break;
+		case COLL_BOTTOM:
+			if (motion->vel_y <= 0.0) return;
+
+			motion->pos_y = y - h;
+			motion->vel_y = -motion->vel_y * GAME_PARTICLE_BOUNCE;
+			break;
+		case COLL_LEFT:
+			if (motion->vel_x <= 0.0) return;
+
+			motion->pos_x = x - size_x;
+			motion->vel_x = -motion->vel_x * GAME_PARTICLE_BOUNCE;
+			break;
+		case COLL_RIGHT:
+			if (motion->vel_x >= 0.0) return;
+
+			motion->pos_x = x + w;
+			motion->vel_x = -motion->vel_x * GAME_PARTICLE_BOUNCE;
+			break;
+		case COLL_NONE:
+			break;
+	}
+
+	motion->bounced = true;
+}
+
+// Bounce the particle off of the rects in `hash` that it overlaps
+// Rects are tested cell by cell, each once, and by index within a cell
+static void collide_particle(
+	struct particles *const particles,
+	struct particle *const particle,
+	const struct rect_hash *const hash)
+{
+	struct particle_motion motion = {
+		.size_x = particle->size_x,
+		.size_y = particle->size_y,
+		.has_velocity = false,
+		.bounced = false
+	};
+	particles_position(particles, particle, &motion.pos_x, &motion.pos_y);
+
+	int first_x;
+	int last_x;
+	int first_y;
+	int last_y;
+
+	if (!rect_hash_cells(hash, motion.pos_x, motion.pos_x + motion.size_x,
+		motion.pos_y - motion.size_y, motion.pos_y,
+		&first_x, &last_x, &first_y, &last_y))
+	{
+		return;
+	}
+
+	for (int cell_y = first_y; cell_y <= last_y; cell_y += 1) {
+		for (int cell_x = first_x; cell_x <= last_x; cell_x += 1) {
+			const unsigned int bucket = cell_y * hash->num_columns + cell_x;
+			const unsigned int end = hash->bucket_starts[bucket + 1];
+
+			for (unsigned int k = hash->bucket_starts[bucket]; k < end;
+				k += 1)
+			{
+				const unsigned int r = hash->entries[k];
+
+				if (rect_hash_owns(hash, r, first_x, first_y, cell_x, cell_y)) {
+					bounce_particle(particles, particle, &motion,
+						&hash->rects[r]);
+				}
+			}
+		}
+	}
+
+	if (motion.bounced) {
+		particles_set_motion(particles, particle,
+			motion.pos_x, motion.pos_y, motion.vel_x, motion.vel_y);
+	}
+}
+
+void game_update_particles(struct game *const game, const uint64_t delta) {
+	particles_update(&game->particles, delta);
+
+	if (!game->particle_collisions || game->particles.num == 0) {
+		return;
+	}
+
+	// Bricks are only removed by compaction, so none are dead here
+	struct rect_hash *const hash = &game->rect_hash;
+	rect_hash_resize(hash, game->num_bricks + 1);
+
+	for (unsigned int b = 0; b < game->num_bricks; b += 1) {
+		const struct brick *const brick = game->bricks[b];
+
+		hash->rects[b] = (struct rect_hash_rect) {
+			.pos_x = brick->pos_x,
+			.pos_y = brick->pos_y,
+			.size_x = brick->size_x,
+			.size_y = brick->size_y
+		};
+	}
+
+	hash->rects[game->num_bricks] = (struct rect_hash_rect) {
+		.pos_x = game->paddle.pos_x,
+		.pos_y = game->paddle.pos_y,
+		.size_x = game->paddle.size_x,
+		.size_y = game->paddle.size_y
+	};
+
+	rect_hash_build(hash);
+
+	// In ring order, so that each particle is read and written once
+	//  and in order. The hash is small enough to stay in the cache
+	for (unsigned int i = 0; i < game->particles.num; i += 1) {
+		collide_particle(&game->particles,
+			particles_get(&game->particles, i), hash);
+	}
+}
+
+void game_update_bricks(struct game *const game, const uint64_t delta) {
+	game->brick_scroll_ns += delta;
+}
+
+void game_update_camera(struct game *const game, const uint64_t delta) {
+	game->camera_time_ns += delta;
+
+	while (game->camera_time_ns >= GAME_CAMERA_STEP_NS) {
+		game->camera_time_ns -= GAME_CAMERA_STEP_NS;
+
+		// Camera shake with springs
+		const double accel_x = -game->camera_spring_constant
+			* (game->viewport_center_x - game->play_area_origin_x)
+			/ game->camera_mass;
+		const double accel_y = -game->camera_spring_constant
+			* (game->viewport_center_y - game->play_area_origin_y)
+			/ game->camera_mass;
+
+		game->camera_vel_x += accel_x;
+		game->camera_vel_y += accel_y;
+
+		game->viewport_center_x += game->camera_vel_x;
+		game->viewport_center_y += game->camera_vel_y;
+
+		game->camera_vel_x *= 0.95;
+		game->camera_vel_y *= 0.95;
+	}
+}
+
+void game_step(
+	struct game *const game,
+	const uint64_t delta,
+	const double paddle_dx)
+{
+	game_update_particles(game, delta);
+
+	game_update_bricks(game, delta);
+
+	game_update_balls(game, delta, paddle_dx);
+
+	// Remove everything that died this frame in one pass
+	game_compact(game);
+
+	// Bounce balls off of each other
+	game_collide_balls(game);
+
+	game_update_camera(game, delta);
 }
 
 double game_x_screen_to_coord(
@@ -367,6 +1176,170 @@ int game_length_to_screen(
 	return round(length * num_pixels / game_length);
 }
 
+void game_viewport_compute(
+	struct game_viewport *const viewport,
+	const struct game *const game,
+	const int pixels_x,
+	const int pixels_y)
+{
+	game_viewport_compute_at(viewport,
+		game->viewport_center_x,
+		game->viewport_center_y,
+		game->viewport_size_x,
+		game->viewport_size_y,
+		pixels_x,
+		pixels_y);
+}
+
+void game_viewport_compute_at(
+	struct game_viewport *const viewport,
+	const double center_x,
+	const double center_y,
+	const double size_x,
+	const double size_y,
+	const int pixels_x,
+	const int pixels_y)
+{
+	// Same math as `game_x_coord_to_screen` and `game_y_coord_to_screen`
+	//  with the division done once
+	const double viewport_left = center_x - (size_x / 2.0);
+	const double viewport_bottom = center_y - (size_y / 2.0);
+
+	viewport->scale_x = (pixels_x - 1) / size_x;
+	viewport->offset_x = -viewport_left * viewport->scale_x;
+
+	viewport->scale_y = -(pixels_y - 1) / size_y;
+	viewport->offset_y = -viewport_bottom * viewport->scale_y + pixels_y;
+
+	viewport->length_scale_x = pixels_x / size_x;
+	viewport->length_scale_y = pixels_y / size_y;
+}
+
+// Round to the nearest int without calling into libm
+static inline int round_to_int(const double value) {
+	const double shifted = value + 0.5;
+	const int truncated = (int)shifted;
+
+	// Truncation went up for negative values
+	return truncated - (shifted < truncated);
+}
+
+SDL_Rect game_viewport_rect(
+	const struct game_viewport *const viewport,
+	const double pos_x,
+	const double pos_y,
+	const double size_x,
+	const double size_y)
+{
+	return (SDL_Rect) {
+		.x = round_to_int(pos_x * viewport->scale_x + viewport->offset_x),
+		.y = round_to_int(pos_y * viewport->scale_y + viewport->offset_y),
+		.w = round_to_int(size_x * viewport->length_scale_x),
+		.h = round_to_int(size_y * viewport->length_scale_y)
+	};
+}
+
+void game_viewport_rects(
+	const struct game_viewport *const viewport,
+	const game_scalar *const pos_x,
+	const game_scalar *const pos_y,
+	const game_scalar *const size_x,
+	const game_scalar *const size_y,
+	const unsigned int num,
+	SDL_Rect *const out)
+{
+	const double scale_x = viewport->scale_x;
+	const double offset_x = viewport->offset_x;
+	const double scale_y = viewport->scale_y;
+	const double offset_y = viewport->offset_y;
+	const double length_scale_x = viewport->length_scale_x;
+	const double length_scale_y = viewport->length_scale_y;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		out[i].x = round_to_int(pos_x[i] * scale_x + offset_x);
+		out[i].y = round_to_int(pos_y[i] * scale_y + offset_y);
+		out[i].w = round_to_int(size_x[i] * length_scale_x);
+		out[i].h = round_to_int(size_y[i] * length_scale_y);
+	}
+}
+
+void game_viewport_frects(
+	const struct game_viewport *const viewport,
+	const game_scalar *const pos_x,
+	const game_scalar *const pos_y,
+	const game_scalar *const size_x,
+	const game_scalar *const size_y,
+	const unsigned int num,
+	SDL_FRect *const out)
+{
+	const double scale_x = viewport->scale_x;
+	const double offset_x = viewport->offset_x;
+	const double scale_y = viewport->scale_y;
+	const double offset_y = viewport->offset_y;
+	const double length_scale_x = viewport->length_scale_x;
+	const double length_scale_y = viewport->length_scale_y;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		out[i].x = pos_x[i] * scale_x + offset_x;
+		out[i].y = pos_y[i] * scale_y + offset_y;
+		out[i].w = size_x[i] * length_scale_x;
+		out[i].h = size_y[i] * length_scale_y;
+	}
+}
+
+void game_viewport_ball_rects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_Rect *const out)
+{
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		const struct ball *const ball = game->balls[i];
+
+		out[i] = game_viewport_rect(viewport,
+			ball->pos_x, ball->pos_y, ball->size_x, ball->size_y);
+	}
+}
+
+void game_viewport_brick_rects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_Rect *const out)
+{
+	for (unsigned int i = 0; i < game->num_bricks; i += 1) {
+		const struct brick *const brick = game->bricks[i];
+
+		out[i] = game_viewport_rect(viewport,
+			brick->pos_x, brick->pos_y, brick->size_x, brick->size_y);
+	}
+}
+
+void game_viewport_particle_frects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_FRect *const out)
+{
+	const double scale_x = viewport->scale_x;
+	const double offset_x = viewport->offset_x;
+	const double scale_y = viewport->scale_y;
+	const double offset_y = viewport->offset_y;
+	const double length_scale_x = viewport->length_scale_x;
+	const double length_scale_y = viewport->length_scale_y;
+
+	for (unsigned int i = 0; i < game->particles.num; i += 1) {
+		const struct particle *const particle =
+			particles_get(&game->particles, i);
+
+		game_scalar pos_x;
+		game_scalar pos_y;
+		particles_position(&game->particles, particle, &pos_x, &pos_y);
+
+		out[i].x = pos_x * scale_x + offset_x;
+		out[i].y = pos_y * scale_y + offset_y;
+		out[i].w = particle->size_x * length_scale_x;
+		out[i].h = particle->size_y * length_scale_y;
+	}
+}
+
 void game_fill_rect_static(
 	const double pos_x,
 	const double pos_y,
@@ -440,10 +1413,14 @@ void game_render_particle(
 	const int pixels_y,
 	SDL_Renderer *const renderer)
 {
+	game_scalar pos_x;
+	game_scalar pos_y;
+	particles_position(&game->particles, particle, &pos_x, &pos_y);
+
 	game_fill_rect(
 		game,
-		particle->pos_x,
-		particle->pos_y,
+		pos_x,
+		pos_y,
 		particle->size_x,
 		particle->size_y,
 		pixels_x,
@@ -2,9 +2,19 @@
 #define GAME_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <SDL2/SDL.h>
 
+#include "collide.h"
+#include "easy_alloc.h"
+#include "game_scalar.h"
+#include "handle.h"
+#include "mip.h"
+#include "particles.h"
+#include "rand.h"
+#include "rect_hash.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -14,86 +24,135 @@ extern "C" {
 // Positive y-axis goes towards top of screen
 
 struct ball {
-	double pos_x;
-	double pos_y;
-
-	double vel_x;
-	double vel_y;
+	game_scalar pos_x;
+	game_scalar pos_y;
 
-	double size_x;
-	double size_y;
+	game_scalar vel_x;
+	game_scalar vel_y;
 
-	SDL_Texture *tex;
+	game_scalar size_x;
+	game_scalar size_y;
 };
 
 struct paddle {
-	double pos_x;
-	double pos_y;
-
-	double size_x;
-	double size_y;
-};
+	game_scalar pos_x;
+	game_scalar pos_y;
 
-struct particle {
-	double pos_x;
-	double pos_y;
-	double size_x;
-	double size_y;
-
-	double vel_x;
-	double vel_y;
-
-	// How long the particle lives in nanoseconds
-	uint64_t lifetime_ns;
-	uint64_t age_ns;// Current age in nanoseconds
-
-	uint8_t r;
-	uint8_t g;
-	uint8_t b;
-	uint8_t a;
+	game_scalar size_x;
+	game_scalar size_y;
 };
 
 struct brick {
-	double pos_x;
-	double pos_y;
+	game_scalar pos_x;
+	game_scalar pos_y;
 
-	double size_x;
-	double size_y;
+	game_scalar size_x;
+	game_scalar size_y;
 
-	SDL_Texture *inner_tex;
+	// Index into `game_textures.bricks`
+	unsigned int inner_tex_index;
 
 	// The rect of the tex to use
 
-	// [0, 1] values
-	double inner_tex_x_prop;
-	double inner_tex_y_prop;
+	// [0, 1] values. Where the rect starts when the level starts
+	// It then scrolls at `inner_tex_<>_prop_speed` (see `brick_scroll_ns`)
+	game_scalar inner_tex_x_prop;
+	game_scalar inner_tex_y_prop;
 
 	int inner_tex_w;
 	int inner_tex_h;
 
 	// Units/ns value to update the inner_tex_<>_prop values
-	double inner_tex_x_prop_speed;
-	double inner_tex_y_prop_speed;
+	game_scalar inner_tex_x_prop_speed;
+	game_scalar inner_tex_y_prop_speed;
 };
 
+// A ball's contact with a brick, found during `game_update_balls`
+struct ball_contact {
+	unsigned int brick;// Index of the brick hit. UINT_MAX if none
+	enum collision coll;
+	// [0, 1] fraction of the frame at which the ball first touched the brick
+	double entry_time;
+
+	bool hit_paddle;
+	bool remove_ball;
+};
+
+// Size of the bricks made by `game_setup`
+#define GAME_MIN_BRICK_SIZE_X 360.0
+#define GAME_MIN_BRICK_SIZE_Y 170.0
+#define GAME_MAX_BRICK_SIZE_X 410.0
+#define GAME_MAX_BRICK_SIZE_Y 220.0
+// Space around each brick made by `game_setup`
+#define GAME_BRICK_MARGIN_X 10.0
+#define GAME_BRICK_MARGIN_Y 10.0
+// Cell size of `game.brick_hash`. About a brick with its margins
+#define GAME_BRICK_CELL_SIZE 400.0
+
+// How long every particle lives
+#define GAME_PARTICLE_LIFETIME_NS 3000000000
+
+// Particle collisions (see `game.particle_collisions`)
+// Cell size of `game.rect_hash`. A bit smaller than a brick
+#define GAME_PARTICLE_CELL_SIZE 256.0
+// Share of its speed into a surface that a particle keeps when it bounces
+#define GAME_PARTICLE_BOUNCE 0.4
+// Share of its speed along the top of a surface that a particle keeps
+//  each step that it lands on or rests on it
+#define GAME_PARTICLE_FRICTION 0.8
+// Units/ns. Slower bounces off of the top of a surface stop the
+//  particle there. About 3 frames of falling at 60 Hz
+#define GAME_PARTICLE_SETTLE_SPEED 0.000002
+
 // Game state
 // What you would serialize to save the game
 struct game {
 	unsigned int balls_len;// Allocated length of balls buffer
 	struct ball **balls;
 	unsigned int num_balls;// Number of balls in the buffer
+	// Indices into `balls` sorted by left edge. Same allocated length as balls
+	// Kept between frames for the sort and sweep broadphase (see sweep.h)
+	unsigned int *ball_order;
+	// Edges in `ball_order` order for the sweep. Same allocated length
+	//  as balls. Scratch space for `game_collide_balls`
+	struct sweep_box *ball_boxes;
+	// Scratch space for `game_update_balls`. Same allocated length as balls
+	struct ball_contact *ball_contacts;
+	struct handle_table ball_handles;
 
 	unsigned int bricks_len;
 	struct brick **bricks;
 	unsigned int num_bricks;
-
-	unsigned int brick_texs_len;
-	SDL_Texture **brick_texs;
-	unsigned int num_brick_texs;
-
-	unsigned int particles_len;
-	struct particle **particles;
-	unsigned int num_particles;
+	// Scratch space for `game_update_balls`. Same allocated length as bricks
+	// Index of the ball whose contact removes the brick. UINT_MAX if none
+	unsigned int *brick_claims;
+	struct handle_table brick_handles;
+	// Every brick in `bricks` as a box, in the same order, for finding
+	//  ball-brick contacts several bricks at a time. Bricks do not move,
+	//  so it only changes when bricks are added or compacted
+	struct collide_boxes brick_boxes;
+	// The bricks by where they are, for finding the ones along a path
+	//  (see `predict_first_brick`). Built at the end of `game_setup` and
+	//  `game_append_brick_grid`. Rect r is the brick with handle
+	//  `brick_hash_handles[r]`, so compacting does not change it
+	struct rect_hash brick_hash;
+	// Same allocated length as bricks
+	struct handle *brick_hash_handles;
+	// False after `game_append_brick` until the hash is built again
+	bool bricks_hashed;
+
+	struct particles particles;
+	// Bounce particles off of bricks and the paddle. Default false
+	// Particles do not change anything else, so a replay (see replay.h)
+	//  plays the same with or without
+	bool particle_collisions;
+	// The bricks, then the paddle, for particles to look up
+	// Built every `game_update_particles` while `particle_collisions`
+	struct rect_hash rect_hash;
+
+	// Balls and bricks of the current level come from here
+	// `game_desetup` gives them all back with one reset
+	struct easy_arena level_arena;
 
 	struct paddle paddle;
 
@@ -108,6 +167,13 @@ struct game {
 	double camera_spring_constant;
 	double camera_vel_x;
 	double camera_vel_y;
+	// Time not yet used by `game_update_camera` (less than one camera step)
+	uint64_t camera_time_ns;
+
+	// How long brick textures have been scrolling since `game_setup`
+	// Scrolling is only drawn, so it is worked out when drawing
+	//  (see `snapshot_brick_src_rects`)
+	uint64_t brick_scroll_ns;
 
 	// The center and dimensions of the play area
 	// So that the camera can move independently
@@ -118,12 +184,44 @@ struct game {
 
 	bool is_setup;
 
-	SDL_Texture *ball_tex;
+	// Use OpenMP inside `game_update_balls`. Default true
+	// Turn off when running many games on their own threads
+	bool parallel;
+
+	// Every random choice the game makes comes from here
+	//  (see `game_seed`)
+	struct rand_state rand;
 };
 
-// Things to do once (no need to repeat if playing a second match)
+#define GAME_NUM_BRICK_TEXS 5
+
+// Textures for drawing a game
+// Kept out of `struct game` so that games do not need a renderer
+struct game_textures {
+	// Mip chain of each brick texture (see mip.h). Level 0 is full size
+	SDL_Texture *brick_mips[GAME_NUM_BRICK_TEXS][MIP_MAX_LEVELS];
+	unsigned int brick_num_mips[GAME_NUM_BRICK_TEXS];
+	// Sizes of level 0, so they do not have to be queried every frame
+	int brick_ws[GAME_NUM_BRICK_TEXS];
+	int brick_hs[GAME_NUM_BRICK_TEXS];
+	SDL_Texture *ball;
+};
+
+// Load the textures from `./assets`
 // Remember that IMG_Init must happen before this
-void game_init(struct game *const game, SDL_Renderer *renderer);
+void game_textures_init(
+	struct game_textures *const textures,
+	SDL_Renderer *renderer);
+
+void game_textures_deinit(struct game_textures *const textures);
+
+// Things to do once (no need to repeat if playing a second match)
+// Does not need SDL to be initialized
+void game_init(struct game *const game);
+
+// Seed the game's random number generator. `game_init` seeds with 0
+// The same seed plays out the same on any thread
+void game_seed(struct game *const game, const uint64_t seed);
 
 // Deallocate and clean up the work done in `game_init`
 // If you have called setup, you should desetup before calling this
@@ -134,23 +232,178 @@ void game_setup(struct game *const game);
 // Game is not valid until you call `game_setup` again
 void game_desetup(struct game *const game);
 
-void game_append_ball(struct game *const game, struct ball *const ball);
+// The `game_new_` functions allocate an entity from `level_arena`
+// It lives until `game_desetup`, so do not free it
+
+struct ball *game_new_ball(struct game *const game);
 
-void game_append_particle(
+struct brick *game_new_brick(struct game *const game);
+
+// The `game_append_` functions return a handle to the new entity
+// Handles stay valid across frames until the entity is removed
+// Append entities from the `game_new_` functions
+
+struct handle game_append_ball(struct game *const game, struct ball *const ball);
+
+struct handle game_append_brick(
 	struct game *const game,
-	struct particle *const particle);
+	struct brick *const brick);
 
-void game_append_brick(struct game *const game, struct brick *const brick);
+// Append a brick for every brick in `grid` (see brick_grid.h)
+struct brick_grid;
+void game_append_brick_grid(
+	struct game *const game,
+	const struct brick_grid *const grid);
 
-// Remove ball at index `i`
-void game_remove_ball(struct game *const game, const unsigned int i);
+// The `game_remove_` functions only mark the entity at index `i` as dead
+// Dead entities are removed all at once by `game_compact`,
+//  so indices stay the same until then
 
-// Remove particle at index `i`
-void game_remove_particle(struct game *const game, const unsigned int i);
+void game_remove_ball(struct game *const game, const unsigned int i);
 
-// Remove brick at index `i`
 void game_remove_brick(struct game *const game, const unsigned int i);
 
+// Remove all dead balls and bricks in one pass
+// Keeps the order of the others. Call at the end of each step
+void game_compact(struct game *const game);
+
+// The `game_get_` functions return the entity that `handle` refers to
+// Return NULL if it has been removed (or marked dead)
+
+struct ball *game_get_ball(
+	const struct game *const game,
+	const struct handle handle);
+
+struct brick *game_get_brick(
+	const struct game *const game,
+	const struct handle handle);
+
+// Move balls forward `delta` nanoseconds and collide them with the walls,
+//  the paddle, and the bricks
+// `paddle_dx` is how far the paddle moved since the last update
+// Ball-brick contacts are found for all balls in parallel (OpenMP),
+//  then resolved in order so the result does not depend on thread count:
+//  when balls hit the same brick, the earliest contact removes it
+//  and the other balls pass through it this frame
+// Dead balls and bricks are marked, not removed (see `game_compact`)
+void game_update_balls(
+	struct game *const game,
+	const uint64_t delta,
+	const double paddle_dx);
+
+// Bounce balls off of each other
+// Uses the sort and sweep broadphase in sweep.h
+// Returns the number of pairs of balls that collided
+unsigned int game_collide_balls(struct game *const game);
+
+// Move the paddle's left edge to `new_x`, kept inside the play area
+// Returns how far the paddle moved (pass it on as `paddle_dx`)
+double game_move_paddle(struct game *const game, const double new_x);
+
+// Remove expired particles and move the rest
+// With `particle_collisions`, then bounce them off of bricks and the paddle
+void game_update_particles(struct game *const game, const uint64_t delta);
+
+// Advance `brick_scroll_ns`
+void game_update_bricks(struct game *const game, const uint64_t delta);
+
+// Nanoseconds per step of the camera spring
+#define GAME_CAMERA_STEP_NS 16666667
+
+// Move the camera towards the play area with a spring
+// The spring takes one step per GAME_CAMERA_STEP_NS of `delta` so that
+//  it behaves the same however often this is called
+void game_update_camera(struct game *const game, const uint64_t delta);
+
+// Do one whole frame of the game besides input and rendering:
+//  particles, bricks, balls, compaction, ball-ball collisions, and camera
+void game_step(
+	struct game *const game,
+	const uint64_t delta,
+	const double paddle_dx);
+
+// Transform from game coordinates to pixels for one frame
+// Compute once per frame with `game_viewport_compute` instead of
+//  calling the `game_*_to_screen` functions for every value
+// Gives the same results as the `game_*_to_screen` functions
+//  (ties between pixels may round the other way)
+struct game_viewport {
+	// pixel_x = pos_x * scale_x + offset_x
+	double scale_x;
+	double offset_x;
+	// pixel_y = pos_y * scale_y + offset_y
+	double scale_y;
+	double offset_y;
+	// Pixels per game unit for sizes
+	double length_scale_x;
+	double length_scale_y;
+};
+
+// Compute the transform for the game's current viewport
+//  and a surface of `pixels_x` by `pixels_y`
+void game_viewport_compute(
+	struct game_viewport *const viewport,
+	const struct game *const game,
+	const int pixels_x,
+	const int pixels_y);
+
+// Same as `game_viewport_compute` for a viewport given by its center
+//  and size in game coordinates
+void game_viewport_compute_at(
+	struct game_viewport *const viewport,
+	const double center_x,
+	const double center_y,
+	const double size_x,
+	const double size_y,
+	const int pixels_x,
+	const int pixels_y);
+
+// Convert one rect to pixels
+SDL_Rect game_viewport_rect(
+	const struct game_viewport *const viewport,
+	const double pos_x,
+	const double pos_y,
+	const double size_x,
+	const double size_y);
+
+// Convert `num` rects given as separate arrays to pixels in one pass
+void game_viewport_rects(
+	const struct game_viewport *const viewport,
+	const game_scalar *const pos_x,
+	const game_scalar *const pos_y,
+	const game_scalar *const size_x,
+	const game_scalar *const size_y,
+	const unsigned int num,
+	SDL_Rect *const out);
+
+// Same as `game_viewport_rects` but without rounding to whole pixels
+void game_viewport_frects(
+	const struct game_viewport *const viewport,
+	const game_scalar *const pos_x,
+	const game_scalar *const pos_y,
+	const game_scalar *const size_x,
+	const game_scalar *const size_y,
+	const unsigned int num,
+	SDL_FRect *const out);
+
+// Convert all balls/bricks/particles of the game to pixels in one pass
+// `out` must have room for `num_balls`/`num_bricks`/`particles.num` rects
+
+void game_viewport_ball_rects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_Rect *const out);
+
+void game_viewport_brick_rects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_Rect *const out);
+
+void game_viewport_particle_frects(
+	const struct game_viewport *const viewport,
+	const struct game *const game,
+	SDL_FRect *const out);
+
 // Translate x pixel coordinate to game coordinate value
 double game_x_screen_to_coord(
 	const int screen_x,
@@ -0,0 +1,14 @@
+#ifndef GAME_SCALAR_H
+#define GAME_SCALAR_H
+
+// Scalar type for entity data
+// Build with `-DGAME_SCALAR_FLOAT` to use float instead of double,
+//  which halves the size of the entity structs.
+// Play area coordinates are small enough for single precision.
+#ifdef GAME_SCALAR_FLOAT
+typedef float game_scalar;
+#else
+typedef double game_scalar;
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+#include "handle.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "easy_alloc.h"
+
+void handle_table_init(struct handle_table *const table) {
+	table->slots_len = 64;
+	table->num_slots = 0;
+	table->generations = easy_malloc(sizeof(uint32_t) * table->slots_len);
+	table->indices = easy_malloc(sizeof(unsigned int) * table->slots_len);
+
+	table->entities_len = 64;
+	table->slots = easy_malloc(sizeof(unsigned int) * table->entities_len);
+	table->dead = easy_malloc(sizeof(bool) * table->entities_len);
+
+	table->free_slots = easy_malloc(sizeof(unsigned int) * table->slots_len);
+	table->num_free = 0;
+}
+
+void handle_table_deinit(struct handle_table *const table) {
+	easy_free(table->generations);
+	easy_free(table->indices);
+	easy_free(table->slots);
+	easy_free(table->dead);
+	easy_free(table->free_slots);
+}
+
+// Make the per-entity buffers at least `len` long
+static void grow_entities(
+	struct handle_table *const table,
+	const unsigned int len)
+{
+	if (len <= table->entities_len) {
+		return;
+	}
+
+	while (len > table->entities_len) {
+		table->entities_len = table->entities_len * 2;
+	}
+
+	table->slots = easy_realloc(
+		table->slots, sizeof(unsigned int) * table->entities_len);
+	table->dead = easy_realloc(
+		table->dead, sizeof(bool) * table->entities_len);
+}
+
+// Make the per-slot buffers at least `len` long
+static void grow_slots(
+	struct handle_table *const table,
+	const unsigned int len)
+{
+	if (len <= table->slots_len) {
+		return;
+	}
+
+	while (len > table->slots_len) {
+		table->slots_len = table->slots_len * 2;
+	}
+
+	table->generations = easy_realloc(
+		table->generations, sizeof(uint32_t) * table->slots_len);
+	table->indices = easy_realloc(
+		table->indices, sizeof(unsigned int) * table->slots_len);
+	table->free_slots = easy_realloc(
+		table->free_slots, sizeof(unsigned int) * table->slots_len);
+}
+
+void handle_table_reserve(
+	struct handle_table *const table,
+	const unsigned int num)
+{
+	grow_entities(table, num);
+	grow_slots(table, num);
+}
+
+struct handle handle_table_add(
+	struct handle_table *const table,
+	const unsigned int index)
+{
+	grow_entities(table, index + 1);
+
+	unsigned int slot;
+
+	if (table->num_free > 0) {
+		table->num_free -= 1;
+		slot = table->free_slots[table->num_free];
+	}
+	else {
+		grow_slots(table, table->num_slots + 1);
+
+		slot = table->num_slots;
+		table->generations[slot] = 0;
+		table->num_slots += 1;
+	}
+
+	table->indices[slot] = index;
+	table->slots[index] = slot;
+	table->dead[index] = false;
+
+	return (struct handle) {
+		.slot = slot,
+		.generation = table->generations[slot]
+	};
+}
+
+struct handle handle_table_get(
+	const struct handle_table *const table,
+	const unsigned int index)
+{
+	const unsigned int slot = table->slots[index];
+
+	return (struct handle) {
+		.slot = slot,
+		.generation = table->generations[slot]
+	};
+}
+
+unsigned int handle_table_lookup(
+	const struct handle_table *const table,
+	const struct handle handle)
+{
+	if (handle.slot >= table->num_slots ||
+	    table->generations[handle.slot] != handle.generation)
+	{
+		return UINT_MAX;
+	}
+
+	const unsigned int index = table->indices[handle.slot];
+
+	if (table->dead[index]) {
+		return UINT_MAX;
+	}
+
+	return index;
+}
+
+unsigned int handle_table_compact(
+	struct handle_table *const table,
+	void **const entities,
+	const unsigned int num)
+{
+	unsigned int kept = 0;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const unsigned int slot = table->slots[i];
+
+		if (table->dead[i]) {
+			table->generations[slot] += 1;
+			table->free_slots[table->num_free] = slot;
+			table->num_free += 1;
+		}
+		else {
+			entities[kept] = entities[i];
+			table->slots[kept] = slot;
+			table->dead[kept] = false;
+			table->indices[slot] = kept;
+			kept += 1;
+		}
+	}
+
+	return kept;
+}
+
+void handle_table_clear(struct handle_table *const table) {
+	// Every slot is free afterwards, so bump the ones that were in use
+	//  and rebuild the free list from scratch
+	for (unsigned int s = 0; s < table->num_slots; s += 1) {
+		table->generations[s] += 1;
+		table->free_slots[s] = s;
+	}
+
+	table->num_free = table->num_slots;
+}
@@ -0,0 +1,79 @@
+#ifndef HANDLE_H
+#define HANDLE_H
+
+// Generational handles for entities stored in a packed array
+// An entity's index in its array changes when the array is compacted,
+//  but its handle does not. Once the entity is removed its slot's
+//  generation goes up so old handles to it never match again.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct handle {
+	uint32_t slot;
+	uint32_t generation;
+};
+
+struct handle_table {
+	unsigned int slots_len;// Allocated length of the per-slot buffers
+	unsigned int num_slots;// Number of slots ever handed out
+	uint32_t *generations;// Per slot
+	unsigned int *indices;// Per slot. Index of the entity in its array
+
+	unsigned int entities_len;// Allocated length of the per-entity buffers
+	unsigned int *slots;// Per entity index
+	// Per entity index. Marked to be removed by the next compaction
+	bool *dead;
+
+	unsigned int *free_slots;// Same allocated length as the slot buffers
+	unsigned int num_free;
+};
+
+void handle_table_init(struct handle_table *const table);
+
+void handle_table_deinit(struct handle_table *const table);
+
+// Make room for `num` entities so that adding them does not allocate
+void handle_table_reserve(
+	struct handle_table *const table,
+	const unsigned int num);
+
+// Give a slot to the entity at `index` (which must be new)
+// Returns its handle
+struct handle handle_table_add(
+	struct handle_table *const table,
+	const unsigned int index);
+
+// Returns the current handle of the entity at `index`
+struct handle handle_table_get(
+	const struct handle_table *const table,
+	const unsigned int index);
+
+// Returns the index of the entity that `handle` refers to
+// Returns UINT_MAX if the entity was removed or is marked dead
+unsigned int handle_table_lookup(
+	const struct handle_table *const table,
+	const struct handle handle);
+
+// Remove the dead entities of an array of `num` pointers in one pass
+// Keeps the order of the rest. Dead entities are not freed:
+//  they belong to whatever allocated them (see `game.level_arena`)
+// Dead entities' handles go stale and their slots are reused
+// Returns the new number of entities
+unsigned int handle_table_compact(
+	struct handle_table *const table,
+	void **const entities,
+	const unsigned int num);
+
+// Make every handle stale. For when all entities were freed
+void handle_table_clear(struct handle_table *const table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+#include "latency.h"
+
+void latency_histogram_init(struct latency_histogram *const hist) {
+	for (unsigned int i = 0; i < LATENCY_NUM_BUCKETS; i += 1) {
+		hist->counts[i] = 0;
+	}
+
+	hist->num = 0;
+	hist->sum_ns = 0;
+	hist->max_ns = 0;
+}
+
+void latency_histogram_add(
+	struct latency_histogram *const hist,
+	const uint64_t ns)
+{
+	uint64_t bucket = ns / LATENCY_BUCKET_NS;
+
+	if (bucket >= LATENCY_NUM_BUCKETS) {
+		bucket = LATENCY_NUM_BUCKETS - 1;
+	}
+
+	hist->counts[bucket] += 1;
+	hist->num += 1;
+	hist->sum_ns += ns;
+
+	if (ns > hist->max_ns) {
+		hist->max_ns = ns;
+	}
+}
+
+uint64_t latency_histogram_quantile(
+	const struct latency_histogram *const hist,
+	const double p)
+{
+	if (hist->num == 0) {
+		return 0;
+	}
+
+	// Smallest count that is at least a `p` share of all of them
+	uint64_t target = p * hist->num;
+
+	if (target < 1) {
+		target = 1;
+	}
+
+	uint64_t seen = 0;
+
+	for (unsigned int i = 0; i < LATENCY_NUM_BUCKETS - 1; i += 1) {
+		seen += hist->counts[i];
+
+		if (seen >= target) {
+			return (uint64_t)(i + 1) * LATENCY_BUCKET_NS;
+		}
+	}
+
+	return hist->max_ns;
+}
+
+void latency_histogram_print_summary(
+	const struct latency_histogram *const hist,
+	const char *const name,
+	FILE *const file)
+{
+	if (hist->num == 0) {
+		fprintf(file, "%s: no samples\n", name);
+		return;
+	}
+
+	fprintf(file, "%s: %lu samples, mean %.2f ms, "
+		"p50 <%.2f ms, p90 <%.2f ms, p99 <%.2f ms, max %.2f ms\n",
+		name,
+		(unsigned long)hist->num,
+		hist->sum_ns / 1000000.0 / hist->num,
+		latency_histogram_quantile(hist, 0.5) / 1000000.0,
+		latency_histogram_quantile(hist, 0.9) / 1000000.0,
+		latency_histogram_quantile(hist, 0.99) / 1000000.0,
+		hist->max_ns / 1000000.0);
+}
+
+void latency_histogram_print(
+	const struct latency_histogram *const hist,
+	const char *const name,
+	FILE *const file)
+{
+	latency_histogram_print_summary(hist, name, file);
+
+	for (unsigned int i = 0; i < LATENCY_NUM_BUCKETS; i += 1) {
+		if (hist->counts[i] == 0) {
+			continue;
+		}
+
+		const double low = (double)i * LATENCY_BUCKET_NS / 1000000.0;
+
+		if (i == LATENCY_NUM_BUCKETS - 1) {
+			fprintf(file, "  %6.2f ms and up  %lu\n",
+				low, (unsigned long)hist->counts[i]);
+		}
+		else {
+			fprintf(file, "  %6.2f - %6.2f ms  %lu\n",
+				low, low + LATENCY_BUCKET_NS / 1000000.0,
+				(unsigned long)hist->counts[i]);
+		}
+	}
+}
+
+void latency_init(struct latency *const latency) {
+	latency_histogram_init(&latency->input_to_present);
+	latency_histogram_init(&latency->frame_age);
+
+	latency->num_inputs = 0;
+	latency->num_shown = 0;
+}
+
+int latency_input(struct latency *const latency, const uint64_t time) {
+	latency->num_inputs += 1;
+	latency->input_times[latency->num_inputs % LATENCY_MAX_PENDING] = time;
+
+	// Drop inputs that have been waiting too long to have a time kept
+	if (latency->num_inputs - latency->num_shown > LATENCY_MAX_PENDING) {
+		latency->num_shown = latency->num_inputs - LATENCY_MAX_PENDING;
+	}
+
+	return latency->num_inputs;
+}
+
+void latency_present(
+	struct latency *const latency,
+	const int sequence,
+	const uint64_t snapshot_time,
+	const uint64_t present_time)
+{
+	latency_histogram_add(&latency->frame_age, present_time - snapshot_time);
+
+	// Every input applied since the last present is now on screen
+	while (latency->num_shown < sequence) {
+		latency->num_shown += 1;
+
+		const uint64_t input_time = latency->input_times[
+			latency->num_shown % LATENCY_MAX_PENDING];
+
+		latency_histogram_add(&latency->input_to_present,
+			present_time > input_time ? present_time - input_time : 0);
+	}
+}
+
+void latency_print_summary(
+	const struct latency *const latency,
+	FILE *const file)
+{
+	latency_histogram_print_summary(
+		&latency->input_to_present, "Input to present", file);
+	latency_histogram_print_summary(
+		&latency->frame_age, "Frame age", file);
+}
+
+void latency_print(const struct latency *const latency, FILE *const file) {
+	latency_histogram_print(
+		&latency->input_to_present, "Input to present", file);
+	latency_histogram_print(&latency->frame_age, "Frame age", file);
+}
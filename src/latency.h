@@ -0,0 +1,91 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Measure how long input takes to reach the screen
+// Each mouse movement gets a sequence number that is carried from the
+//  render thread through the sim thread and back in a snapshot,
+//  so the present that first shows it can be found.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_BUCKET_NS 250000
+// The last bucket also counts everything longer
+#define LATENCY_NUM_BUCKETS 200
+
+// Inputs that can wait to be shown at once. Older ones are dropped
+#define LATENCY_MAX_PENDING 64
+
+struct latency_histogram {
+	// Bucket i counts durations in [i, i + 1) * LATENCY_BUCKET_NS
+	uint64_t counts[LATENCY_NUM_BUCKETS];
+	uint64_t num;
+	uint64_t sum_ns;
+	uint64_t max_ns;
+};
+
+void latency_histogram_init(struct latency_histogram *const hist);
+
+void latency_histogram_add(
+	struct latency_histogram *const hist,
+	const uint64_t ns);
+
+// Returns the upper edge of the bucket that holds the `p` quantile
+//  (`p` in [0, 1]), or 0 if the histogram is empty
+uint64_t latency_histogram_quantile(
+	const struct latency_histogram *const hist,
+	const double p);
+
+// One line: count, mean, median, 90th and 99th percentile, and max
+void latency_histogram_print_summary(
+	const struct latency_histogram *const hist,
+	const char *const name,
+	FILE *const file);
+
+// Summary, then a line for every bucket that is not empty
+void latency_histogram_print(
+	const struct latency_histogram *const hist,
+	const char *const name,
+	FILE *const file);
+
+struct latency {
+	// From the input event to SDL_RenderPresent returning with it on screen
+	struct latency_histogram input_to_present;
+	// From capturing a snapshot to SDL_RenderPresent returning with it
+	struct latency_histogram frame_age;
+
+	int num_inputs;// Sequence number of the newest input
+	int num_shown;// Inputs up to this sequence number have been shown
+	// Time of input `sequence` is at [sequence % LATENCY_MAX_PENDING]
+	uint64_t input_times[LATENCY_MAX_PENDING];
+};
+
+void latency_init(struct latency *const latency);
+
+// An input that happened at `time` (`nsec_time`) is being sent on
+// Returns its sequence number, to hand to whatever applies the input
+int latency_input(struct latency *const latency, const uint64_t time);
+
+// A frame was presented at `present_time` from a snapshot that was
+//  captured at `snapshot_time` and has inputs up to `sequence` applied
+void latency_present(
+	struct latency *const latency,
+	const int sequence,
+	const uint64_t snapshot_time,
+	const uint64_t present_time);
+
+void latency_print_summary(
+	const struct latency *const latency,
+	FILE *const file);
+
+void latency_print(const struct latency *const latency, FILE *const file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
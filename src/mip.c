@@ -0,0 +1,98 @@
+#include "mip.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sdlu.h"
+
+void mip_halve_pixels(
+	const uint8_t *const src,
+	const int src_w,
+	const int src_h,
+	const int src_pitch,
+	uint8_t *const dst,
+	const int dst_pitch)
+{
+	const int dst_w = (src_w / 2 < 1) ? 1 : src_w / 2;
+	const int dst_h = (src_h / 2 < 1) ? 1 : src_h / 2;
+
+	// A side of 1 can not be halved, so the same texel is used twice
+	const int step_x = (src_w > 1) ? 4 : 0;
+	const int step_y = (src_h > 1) ? src_pitch : 0;
+
+	for (int y = 0; y < dst_h; y += 1) {
+		const uint8_t *const row0 = src + 2 * y * src_pitch;
+		const uint8_t *const row1 = row0 + step_y;
+		uint8_t *const out = dst + y * dst_pitch;
+
+		for (int x = 0; x < dst_w; x += 1) {
+			const uint8_t *const a = row0 + 8 * x;
+			const uint8_t *const b = row1 + 8 * x;
+
+			// Each channel on its own. +2 rounds to nearest
+			for (int c = 0; c < 4; c += 1) {
+				out[4 * x + c] = (a[c] + a[step_x + c]
+					+ b[c] + b[step_x + c] + 2) / 4;
+			}
+		}
+	}
+}
+
+SDL_Surface *mip_halve_surface(SDL_Surface *const surface) {
+	if (surface->format->BytesPerPixel != 4) {
+		fprintf(stderr, "%s: Surface has %d bytes per pixel instead of 4\n",
+			__func__, surface->format->BytesPerPixel);
+
+		exit(EXIT_FAILURE);
+	}
+
+	const int w = (surface->w / 2 < 1) ? 1 : surface->w / 2;
+	const int h = (surface->h / 2 < 1) ? 1 : surface->h / 2;
+
+	SDL_Surface *const half = sdlu_create_rgb_surface_with_format(
+		w, h, surface->format->format);
+
+	sdlu_lock_surface(surface);
+	sdlu_lock_surface(half);
+
+	mip_halve_pixels(surface->pixels, surface->w, surface->h, surface->pitch,
+		half->pixels, half->pitch);
+
+	SDL_UnlockSurface(half);
+	SDL_UnlockSurface(surface);
+
+	return half;
+}
+
+unsigned int mip_create_textures(
+	SDL_Renderer *const renderer,
+	SDL_Surface *const surface,
+	SDL_Texture **const levels)
+{
+	SDL_Surface *level_surf =
+		sdlu_convert_surface_format(surface, SDL_PIXELFORMAT_RGBA32);
+
+	unsigned int num_levels = 0;
+
+	while (true) {
+		levels[num_levels] =
+			sdlu_create_texture_from_surface(renderer, level_surf);
+		num_levels += 1;
+
+		if (num_levels == MIP_MAX_LEVELS
+			|| level_surf->w / 2 < MIP_MIN_SIZE
+			|| level_surf->h / 2 < MIP_MIN_SIZE)
+		{
+			break;
+		}
+
+		SDL_Surface *const next = mip_halve_surface(level_surf);
+		SDL_FreeSurface(level_surf);
+		level_surf = next;
+	}
+
+	SDL_FreeSurface(level_surf);
+
+	return num_levels;
+}
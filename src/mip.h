@@ -0,0 +1,75 @@
+#ifndef MIP_H
+#define MIP_H
+
+// Mip chains for textures that are drawn smaller than they are
+// Each level is half the width and height of the one before, made with
+//  a 2x2 box filter. Drawing from the level closest to the size on screen
+//  reads far fewer texels and shimmers less than drawing from level 0.
+
+#include <SDL2/SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIP_MAX_LEVELS 8
+
+// Stop halving once either side would be smaller than this
+#define MIP_MIN_SIZE 8
+
+// Average each 2x2 block of a 4 bytes per pixel image into one pixel
+// `dst` is `src_w / 2` by `src_h / 2` (at least 1). For odd sizes, the
+//  last column/row is left out
+void mip_halve_pixels(
+	const uint8_t *const src,
+	const int src_w,
+	const int src_h,
+	const int src_pitch,
+	uint8_t *const dst,
+	const int dst_pitch);
+
+// New surface half the size of `surface`, which must be 4 bytes per pixel
+// If error, print to stderr and exit
+SDL_Surface *mip_halve_surface(SDL_Surface *const surface);
+
+// Make a texture for each level of `surface`'s mip chain into `levels`
+// Converts to RGBA32 first. Returns the number of levels (at least 1)
+unsigned int mip_create_textures(
+	SDL_Renderer *const renderer,
+	SDL_Surface *const surface,
+	SDL_Texture **const levels);
+
+// Level to draw from when `texels` of level 0 are drawn `pixels` wide:
+//  the smallest level that still has at least one texel per pixel
+static inline unsigned int mip_level(
+	const int texels,
+	const int pixels,
+	const unsigned int num_levels)
+{
+	unsigned int level = 0;
+
+	while (level + 1 < num_levels && (texels >> (level + 1)) >= pixels) {
+		level += 1;
+	}
+
+	return level;
+}
+
+// `rect` of level 0 in the coordinates of `level`
+static inline SDL_Rect mip_rect(const SDL_Rect rect, const unsigned int level) {
+	const int w = rect.w >> level;
+	const int h = rect.h >> level;
+
+	return (SDL_Rect) {
+		.x = rect.x >> level,
+		.y = rect.y >> level,
+		.w = (w < 1) ? 1 : w,
+		.h = (h < 1) ? 1 : h
+	};
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,14 +4,88 @@
 #include <stdlib.h>
 #include <time.h>
 
+// Set by `nsec_calibrate`. 0 until then
+static double ns_per_tick = 0.0;
+
 uint64_t nsec_time() {
 	struct timespec ts;
 
-	if (timespec_get(&ts, TIME_UTC) == 0) {
-		fprintf(stderr, "%s: timespec_get error\n", __func__);
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		fprintf(stderr, "%s: clock_gettime error\n", __func__);
 
 		exit(EXIT_FAILURE);
 	}
 
 	return ((uint64_t)ts.tv_sec) * 1000000000llu + ((uint64_t)ts.tv_nsec);
 }
+
+uint64_t nsec_cpu_time() {
+	const clock_t c = clock();
+
+	if (c == (clock_t)-1) {
+		fprintf(stderr, "%s: clock error\n", __func__);
+
+		exit(EXIT_FAILURE);
+	}
+
+	return (uint64_t)c * (1000000000llu / CLOCKS_PER_SEC);
+}
+
+void nsec_calibrate() {
+	const uint64_t time_start = nsec_time();
+	const uint64_t ticks_start = nsec_ticks();
+
+	// Long enough that reading the clocks is a tiny part of it
+	while (nsec_time() - time_start < 10000000) {}
+
+	const uint64_t ticks_end = nsec_ticks();
+	const uint64_t time_end = nsec_time();
+
+	ns_per_tick = (double)(time_end - time_start) / (ticks_end - ticks_start);
+}
+
+uint64_t nsec_ticks_to_ns(const uint64_t ticks) {
+	if (ns_per_tick == 0.0) {
+		nsec_calibrate();
+	}
+
+	return ticks * ns_per_tick;
+}
+
+void nsec_delta_init(struct nsec_delta *const delta, const uint64_t max_ns) {
+	delta->max_ns = max_ns;
+	delta->last = nsec_time();
+	delta->pending_ns = 0;
+	delta->average_ns = 0.0;
+}
+
+uint64_t nsec_delta_next(struct nsec_delta *const delta) {
+	const uint64_t now = nsec_time();
+	uint64_t raw = now - delta->last;
+	delta->last = now;
+
+	if (raw > delta->max_ns) {
+		raw = delta->max_ns;
+	}
+
+	delta->pending_ns += raw;
+
+	// Moving average over about the last 8 calls
+	delta->average_ns += (raw - delta->average_ns) / 8.0;
+
+	uint64_t out = delta->average_ns;
+
+	// Never hand out time that has not passed yet...
+	if (out > delta->pending_ns) {
+		out = delta->pending_ns;
+	}
+
+	// ...and never fall more than `max_ns` behind
+	if (delta->pending_ns - out > delta->max_ns) {
+		out = delta->pending_ns - delta->max_ns;
+	}
+
+	delta->pending_ns -= out;
+
+	return out;
+}
@@ -1,15 +1,65 @@
 #ifndef NSEC_H
 #define NSEC_H
 
+// Time in nanoseconds
+// - `nsec_time`: monotonic clock for the game loop and anything that
+//   takes differences. Not affected by changes to the system clock
+// - `nsec_ticks`: a raw cycle counter for timing very short stretches
+//   of code (profiling). Convert differences with `nsec_ticks_to_ns`
+// - `struct nsec_delta`: frame deltas that are safe to feed to physics
+
 #include <stdint.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Returns UTC time in nanoseconds
+// Returns monotonic time in nanoseconds from an arbitrary start
+// Only differences are meaningful
 uint64_t nsec_time();
 
+// Returns CPU time used by the process (all threads) in nanoseconds
+uint64_t nsec_cpu_time();
+
+// Returns a count that goes up at a fixed rate (the TSC on x86)
+// Much cheaper than `nsec_time`. Falls back to `nsec_time` elsewhere
+static inline uint64_t nsec_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return nsec_time();
+#endif
+}
+
+// Measure how fast `nsec_ticks` counts against `nsec_time`
+// Takes about 10 ms. Done on the first `nsec_ticks_to_ns` if not before
+// Not thread safe: call before starting threads that use ticks
+void nsec_calibrate();
+
+// Convert a difference of `nsec_ticks` to nanoseconds
+uint64_t nsec_ticks_to_ns(const uint64_t ticks);
+
+// Turns clock readings into deltas for the game loop
+// Long gaps (a breakpoint, a dragged window) are cut to `max_ns`
+//  instead of making everything jump.
+// Jitter is smoothed, but the deltas add up to the clamped time
+//  that really passed (within `max_ns`), so the game does not drift.
+struct nsec_delta {
+	uint64_t max_ns;
+	uint64_t last;// `nsec_time` of the last call
+	uint64_t pending_ns;// Time passed that has not been handed out yet
+	double average_ns;
+};
+
+void nsec_delta_init(struct nsec_delta *const delta, const uint64_t max_ns);
+
+// Returns the nanoseconds to step the game by
+uint64_t nsec_delta_next(struct nsec_delta *const delta);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,67 @@
+#include "pace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "nsec.h"
+
+// Sleep for about `ns`. May wake up late (or, if interrupted, early)
+static void sleep_ns(const uint64_t ns) {
+	const struct timespec ts = {
+		.tv_sec = ns / 1000000000llu,
+		.tv_nsec = ns % 1000000000llu
+	};
+
+	nanosleep(&ts, NULL);
+}
+
+void pace_init(struct pace *const pace, const double frames_per_sec) {
+	if (!(frames_per_sec > 0.0)) {
+		fprintf(stderr, "%s: frames_per_sec must be positive. Got %f\n",
+			__func__, frames_per_sec);
+		exit(EXIT_FAILURE);
+	}
+
+	pace->frame_ns = 1000000000.0 / frames_per_sec;
+	pace->deadline = nsec_time();
+	pace->oversleep_ns = 0;
+}
+
+uint64_t pace_wait(struct pace *const pace) {
+	uint64_t now = nsec_time();
+
+	const uint64_t margin = PACE_SPIN_NS + pace->oversleep_ns;
+
+	if (now + margin < pace->deadline) {
+		const uint64_t asked = pace->deadline - margin - now;
+
+		sleep_ns(asked);
+
+		const uint64_t after = nsec_time();
+		const uint64_t slept = after - now;
+		const uint64_t oversleep = slept > asked ? slept - asked : 0;
+
+		// Decay by 1/16 per sleep
+		pace->oversleep_ns -= pace->oversleep_ns / 16;
+
+		if (oversleep > pace->oversleep_ns) {
+			pace->oversleep_ns = oversleep;
+		}
+
+		now = after;
+	}
+
+	while (now < pace->deadline) {
+		now = nsec_time();
+	}
+
+	if (now - pace->deadline > pace->frame_ns) {
+		pace->deadline = now + pace->frame_ns;
+	}
+	else {
+		pace->deadline += pace->frame_ns;
+	}
+
+	return now;
+}
@@ -0,0 +1,38 @@
+#ifndef PACE_H
+#define PACE_H
+
+// Frame pacing: start frames at a steady rate without burning a core
+// Sleeps for most of the time left in the frame, then spins only for the
+//  last moment so that the frame still starts on time.
+// How late sleeps wake up is learned as it goes and slept less to match.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Spin for at least this long before each deadline (ns)
+#define PACE_SPIN_NS 200000
+
+struct pace {
+	uint64_t frame_ns;// Target time between frame starts
+	uint64_t deadline;// `nsec_time` at which the next frame should start
+	// How much later than asked for sleeps have woken up (ns)
+	// A maximum that decays, so that one slow wake up does not last forever
+	uint64_t oversleep_ns;
+};
+
+// If `frames_per_sec` is not positive, prints to stderr and exits
+void pace_init(struct pace *const pace, const double frames_per_sec);
+
+// Wait until the next frame should start and return the time (`nsec_time`)
+// If the caller fell more than a frame behind, the next frame starts now
+//  instead of trying to catch up with a burst of frames
+uint64_t pace_wait(struct pace *const pace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
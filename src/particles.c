@@ -0,0 +1,129 @@
+#include "particles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "easy_alloc.h"
+
+void particles_init(
+	struct particles *const particles,
+	const unsigned int len,
+	const uint64_t lifetime_ns)
+{
+	unsigned int pow2 = 1;
+
+	while (pow2 < len) {
+		pow2 *= 2;
+	}
+
+	particles->ring = easy_malloc(sizeof(struct particle) * pow2);
+	particles->len = pow2;
+	particles->head = 0;
+	particles->num = 0;
+	particles->time_ns = 0;
+	particles->lifetime_ns = lifetime_ns;
+}
+
+void particles_deinit(struct particles *const particles) {
+	easy_free(particles->ring);
+}
+
+void particles_clear(struct particles *const particles) {
+	particles->head = 0;
+	particles->num = 0;
+}
+
+// Double the ring, unwrapping it so that the oldest particle is at 0
+static void grow(struct particles *const particles) {
+	if (particles->len > UINT32_MAX / 2) {
+		fprintf(stderr, "%s: too many particles: %u\n",
+			__func__, particles->num);
+		exit(EXIT_FAILURE);
+	}
+
+	const unsigned int new_len = particles->len * 2;
+	struct particle *const ring =
+		easy_malloc(sizeof(struct particle) * new_len);
+
+	// The ring is full, so it is [head, len) followed by [0, head)
+	const unsigned int first = particles->len - particles->head;
+
+	memcpy(ring, particles->ring + particles->head,
+		sizeof(struct particle) * first);
+	memcpy(ring + first, particles->ring,
+		sizeof(struct particle) * particles->head);
+
+	easy_free(particles->ring);
+
+	particles->ring = ring;
+	particles->len = new_len;
+	particles->head = 0;
+}
+
+struct particle *particles_spawn(struct particles *const particles) {
+	if (particles->num == particles->len) {
+		grow(particles);
+	}
+
+	struct particle *const particle =
+		particles_get(particles, particles->num);
+
+	particles->num += 1;
+	particle->spawn_ns = particles->time_ns;
+
+	return particle;
+}
+
+#ifdef PARTICLES_STEPPED
+// Move `num` particles in a row that does not wrap
+static void move(
+	struct particle *const particles,
+	const unsigned int num,
+	const game_scalar sdelta)
+{
+	const game_scalar dvel_y = PARTICLES_GRAVITY * sdelta;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		struct particle *const particle = &particles[i];
+
+		// particle->vel_x *= 0.999;// Probably looks better without this
+		particle->vel_y -= dvel_y;
+
+		particle->pos_x += particle->vel_x * sdelta;
+		particle->pos_y += particle->vel_y * sdelta;
+	}
+}
+
+#endif
+
+void particles_update(struct particles *const particles, const uint64_t delta) {
+	particles->time_ns += delta;
+
+	// The oldest are at the head
+	while (particles->num > 0) {
+		const struct particle *const oldest =
+			&particles->ring[particles->head];
+
+		if (particles->time_ns - oldest->spawn_ns < particles->lifetime_ns) {
+			break;
+		}
+
+		particles->head = (particles->head + 1) & (particles->len - 1);
+		particles->num -= 1;
+	}
+
+#ifdef PARTICLES_STEPPED
+	// Live particles are [head, head + num) around the ring
+	const game_scalar sdelta = (game_scalar)delta;
+	const unsigned int to_end = particles->len - particles->head;
+
+	if (particles->num <= to_end) {
+		move(particles->ring + particles->head, particles->num, sdelta);
+	}
+	else {
+		move(particles->ring + particles->head, to_end, sdelta);
+		move(particles->ring, particles->num - to_end, sdelta);
+	}
+#endif
+}
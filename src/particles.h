@@ -0,0 +1,162 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+// Particles in a ring buffer, oldest first
+// Every particle lives for the same time, so they die in the order they
+//  were spawned: expiring is only moving the head forward.
+// Particles store when they were spawned rather than their age,
+//  so nothing has to be written to a particle to age it.
+// Motion is ballistic, so by default a particle keeps only its spawn
+//  position and velocity and `particles_position` works out where it is
+//  now. Nothing is written to a particle after it spawns unless it
+//  bounces (see `particles_set_motion`), and particles that are not
+//  drawn cost nothing.
+// Build with -DPARTICLES_STEPPED to move every particle each update instead
+
+#include <stdint.h>
+
+#include "game_scalar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Units/ns^2 pulling particles down
+#define PARTICLES_GRAVITY 0.00000000000004
+
+struct particle {
+	// Where and how fast the particle was when spawned. With
+	//  PARTICLES_STEPPED, where it is now and how fast it is going
+	// Read the position with `particles_position`
+	game_scalar pos_x;
+	game_scalar pos_y;
+	game_scalar size_x;
+	game_scalar size_y;
+
+	game_scalar vel_x;
+	game_scalar vel_y;
+
+	uint64_t spawn_ns;// `particles.time_ns` when spawned
+
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+	uint8_t a;
+};
+
+struct particles {
+	struct particle *ring;
+	unsigned int len;// Allocated length of `ring`. A power of 2
+	unsigned int head;// Index in `ring` of the oldest particle
+	unsigned int num;
+
+	uint64_t time_ns;// Time passed since `particles_init`
+	uint64_t lifetime_ns;// How long every particle lives
+};
+
+// `len` is rounded up to a power of 2. The ring grows when full
+void particles_init(
+	struct particles *const particles,
+	const unsigned int len,
+	const uint64_t lifetime_ns);
+
+void particles_deinit(struct particles *const particles);
+
+// Remove all particles
+void particles_clear(struct particles *const particles);
+
+// Add a particle and return it for the caller to fill in
+// `spawn_ns` is already set. The pointer is only valid until the next spawn
+struct particle *particles_spawn(struct particles *const particles);
+
+// The `i`th oldest particle. `i` must be less than `num`
+static inline struct particle *particles_get(
+	const struct particles *const particles,
+	const unsigned int i)
+{
+	return &particles->ring[(particles->head + i) & (particles->len - 1)];
+}
+
+// Where `particle` is at `particles->time_ns`
+static inline void particles_position(
+	const struct particles *const particles,
+	const struct particle *const particle,
+	game_scalar *const pos_x,
+	game_scalar *const pos_y)
+{
+#ifdef PARTICLES_STEPPED
+	(void)particles;
+
+	*pos_x = particle->pos_x;
+	*pos_y = particle->pos_y;
+#else
+	const game_scalar t = (game_scalar)(particles->time_ns - particle->spawn_ns);
+
+	*pos_x = particle->pos_x + particle->vel_x * t;
+	*pos_y = particle->pos_y
+		+ (particle->vel_y - 0.5 * PARTICLES_GRAVITY * t) * t;
+#endif
+}
+
+// How fast `particle` is going at `particles->time_ns`
+static inline void particles_velocity(
+	const struct particles *const particles,
+	const struct particle *const particle,
+	game_scalar *const vel_x,
+	game_scalar *const vel_y)
+{
+#ifdef PARTICLES_STEPPED
+	(void)particles;
+
+	*vel_x = particle->vel_x;
+	*vel_y = particle->vel_y;
+#else
+	const game_scalar t = (game_scalar)(particles->time_ns - particle->spawn_ns);
+
+	*vel_x = particle->vel_x;
+	*vel_y = particle->vel_y - PARTICLES_GRAVITY * t;
+#endif
+}
+
+// Put `particle` at (`pos_x`, `pos_y`) going (`vel_x`, `vel_y`) as of
+//  `particles->time_ns`, e.g. after it bounced
+// Without PARTICLES_STEPPED this sets the spawn position and velocity
+//  that lead to that motion. `spawn_ns` is kept so that the particle
+//  still dies in spawn order
+static inline void particles_set_motion(
+	const struct particles *const particles,
+	struct particle *const particle,
+	const game_scalar pos_x,
+	const game_scalar pos_y,
+	const game_scalar vel_x,
+	const game_scalar vel_y)
+{
+#ifdef PARTICLES_STEPPED
+	(void)particles;
+
+	particle->pos_x = pos_x;
+	particle->pos_y = pos_y;
+	particle->vel_x = vel_x;
+	particle->vel_y = vel_y;
+#else
+	const game_scalar t = (game_scalar)(particles->time_ns - particle->spawn_ns);
+
+	// Inverse of `particles_position` and `particles_velocity`
+	particle->vel_x = vel_x;
+	particle->vel_y = vel_y + PARTICLES_GRAVITY * t;
+	particle->pos_x = pos_x - vel_x * t;
+	particle->pos_y = pos_y
+		- (particle->vel_y - 0.5 * PARTICLES_GRAVITY * t) * t;
+#endif
+}
+
+// Move time forward by `delta` nanoseconds and remove the particles that
+//  have lived for `lifetime_ns`
+// With PARTICLES_STEPPED, also move the rest
+void particles_update(struct particles *const particles, const uint64_t delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
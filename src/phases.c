@@ -0,0 +1,58 @@
+#include "phases.h"
+
+#include "nsec.h"
+#include "predict.h"
+
+const char *const phase_names[NUM_PHASES] = {
+	"control",
+	"particles",
+	"bricks",
+	"balls",
+	"compact",
+	"collide",
+	"camera"
+};
+
+unsigned int phases_step(
+	struct game *const game,
+	const uint64_t delta,
+	const struct replay_step *const input,
+	uint64_t ticks[NUM_PHASES])
+{
+	const uint64_t step_delta = (input != NULL) ? input->delta : delta;
+
+	// Phases are timed with `nsec_ticks`, which is cheap enough to call
+	//  several times per step
+	uint64_t t[NUM_PHASES + 1];
+
+	t[PHASE_CONTROL] = nsec_ticks();
+	const double paddle_dx = (input != NULL)
+		? replay_apply(game, input)
+		: predict_control_paddle(game, step_delta);
+
+	t[PHASE_PARTICLES] = nsec_ticks();
+	game_update_particles(game, step_delta);
+
+	t[PHASE_BRICKS] = nsec_ticks();
+	game_update_bricks(game, step_delta);
+
+	t[PHASE_BALLS] = nsec_ticks();
+	game_update_balls(game, step_delta, paddle_dx);
+
+	t[PHASE_COMPACT] = nsec_ticks();
+	game_compact(game);
+
+	t[PHASE_COLLIDE] = nsec_ticks();
+	const unsigned int num_collisions = game_collide_balls(game);
+
+	t[PHASE_CAMERA] = nsec_ticks();
+	game_update_camera(game, step_delta);
+
+	t[NUM_PHASES] = nsec_ticks();
+
+	for (unsigned int i = 0; i < NUM_PHASES; i += 1) {
+		ticks[i] += t[i + 1] - t[i];
+	}
+
+	return num_collisions;
+}
@@ -0,0 +1,45 @@
+#ifndef PHASES_H
+#define PHASES_H
+
+// One fixed step of a headless game, split into timed phases
+// Shared by sim.bin and perfcheck.bin so that they measure the same thing
+
+#include <stdint.h>
+
+#include "game.h"
+#include "replay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Phases of a fixed step, in the order they run
+enum phase {
+	PHASE_CONTROL = 0,
+	PHASE_PARTICLES,
+	PHASE_BRICKS,
+	PHASE_BALLS,
+	PHASE_COMPACT,
+	PHASE_COLLIDE,
+	PHASE_CAMERA,
+	NUM_PHASES
+};
+
+extern const char *const phase_names[NUM_PHASES];
+
+// Same frame as `game_step`, with the input of a recorded step
+//  (see replay.h), or if `input` is NULL, the paddle moved by
+//  `predict_control_paddle` for `delta`
+// Adds the `nsec_ticks` spent in each phase to `ticks`
+// Returns the number of pairs of balls that collided
+unsigned int phases_step(
+	struct game *const game,
+	const uint64_t delta,
+	const struct replay_step *const input,
+	uint64_t ticks[NUM_PHASES]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,184 @@
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "easy_alloc.h"
+
+// Tasks [begin, end) that a worker has left
+// Padded to its own cache lines so that workers do not slow each other down
+struct pool_worker {
+	_Alignas(64) pthread_mutex_t lock;
+	unsigned int begin;
+	unsigned int end;
+};
+
+struct pool_shared {
+	struct pool_worker *workers;
+	unsigned int num_workers;
+	pool_task_fn fn;
+	void *data;
+};
+
+struct pool_thread_arg {
+	struct pool_shared *shared;
+	unsigned int worker;
+};
+
+// Take the next task from worker `w`'s own range
+// Returns false if it is empty
+static bool take_own(struct pool_worker *const w, unsigned int *const task) {
+	bool found = false;
+
+	pthread_mutex_lock(&w->lock);
+
+	if (w->begin < w->end) {
+		*task = w->begin;
+		w->begin += 1;
+		found = true;
+	}
+
+	pthread_mutex_unlock(&w->lock);
+
+	return found;
+}
+
+// Move the back half of some other worker's range to worker `self`
+// Returns false if every other worker is out of tasks
+static bool steal(struct pool_shared *const shared, const unsigned int self) {
+	for (unsigned int i = 1; i < shared->num_workers; i += 1) {
+		struct pool_worker *const victim =
+			&shared->workers[(self + i) % shared->num_workers];
+
+		pthread_mutex_lock(&victim->lock);
+
+		const unsigned int left = victim->end - victim->begin;
+
+		if (left == 0) {
+			pthread_mutex_unlock(&victim->lock);
+			continue;
+		}
+
+		// Round up so that a single task can be stolen
+		const unsigned int take = (left + 1) / 2;
+		const unsigned int end = victim->end;
+		victim->end -= take;
+
+		pthread_mutex_unlock(&victim->lock);
+
+		struct pool_worker *const own = &shared->workers[self];
+
+		pthread_mutex_lock(&own->lock);
+		own->begin = end - take;
+		own->end = end;
+		pthread_mutex_unlock(&own->lock);
+
+		return true;
+	}
+
+	return false;
+}
+
+// Tasks are never added, so once nothing can be stolen the worker is done
+static void *pool_thread(void *const arg) {
+	const struct pool_thread_arg *const thread_arg = arg;
+	struct pool_shared *const shared = thread_arg->shared;
+	const unsigned int self = thread_arg->worker;
+
+	do {
+		unsigned int task;
+
+		while (take_own(&shared->workers[self], &task)) {
+			shared->fn(shared->data, task, self);
+		}
+	} while (steal(shared, self));
+
+	return NULL;
+}
+
+unsigned int pool_num_cores(void) {
+	const long num = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (num < 1) ? 1 : (unsigned int)num;
+}
+
+void pool_run(
+	unsigned int num_threads,
+	const unsigned int num_tasks,
+	const pool_task_fn fn,
+	void *const data)
+{
+	if (num_threads == 0) {
+		num_threads = pool_num_cores();
+	}
+
+	// More threads than tasks would only have nothing to do
+	if (num_threads > num_tasks) {
+		num_threads = (num_tasks == 0) ? 1 : num_tasks;
+	}
+
+	struct pool_worker *const workers =
+		aligned_alloc(64, sizeof(struct pool_worker) * num_threads);
+
+	if (workers == NULL) {
+		fprintf(stderr, "%s: aligned_alloc returned NULL\n", __func__);
+		exit(EXIT_FAILURE);
+	}
+
+	struct pool_shared shared = {
+		.workers = workers,
+		.num_workers = num_threads,
+		.fn = fn,
+		.data = data
+	};
+
+	// Even shares to start with
+	for (unsigned int i = 0; i < num_threads; i += 1) {
+		pthread_mutex_init(&workers[i].lock, NULL);
+		workers[i].begin =
+			(unsigned int)((uint64_t)num_tasks * i / num_threads);
+		workers[i].end =
+			(unsigned int)((uint64_t)num_tasks * (i + 1) / num_threads);
+	}
+
+	struct pool_thread_arg *const args =
+		easy_malloc(sizeof(struct pool_thread_arg) * num_threads);
+	pthread_t *const threads = easy_malloc(sizeof(pthread_t) * num_threads);
+
+	for (unsigned int i = 0; i < num_threads; i += 1) {
+		args[i] = (struct pool_thread_arg) {
+			.shared = &shared,
+			.worker = i
+		};
+	}
+
+	// Worker 0 runs on the calling thread
+	for (unsigned int i = 1; i < num_threads; i += 1) {
+		const int code =
+			pthread_create(&threads[i], NULL, pool_thread, &args[i]);
+
+		if (code != 0) {
+			fprintf(stderr, "%s: pthread_create error code: %d\n",
+				__func__, code);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	pool_thread(&args[0]);
+
+	for (unsigned int i = 1; i < num_threads; i += 1) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (unsigned int i = 0; i < num_threads; i += 1) {
+		pthread_mutex_destroy(&workers[i].lock);
+	}
+
+	easy_free(threads);
+	easy_free(args);
+	free(workers);// From `aligned_alloc`, not `easy_malloc`
+}
@@ -0,0 +1,34 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Work-stealing thread pool for running many independent tasks
+// Each thread starts with an even share of the task indices.
+// A thread that runs out steals half of what another thread has left,
+//  so uneven tasks still keep every core busy until the end.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// `task` is in [0, `num_tasks`). `worker` is in [0, `num_threads`)
+//  and is only ever used by one task at a time (e.g. for scratch space)
+typedef void (*pool_task_fn)(void *data, unsigned int task, unsigned int worker);
+
+// Number of cores online. At least 1
+unsigned int pool_num_cores(void);
+
+// Run `fn` once for every task on `num_threads` threads
+//  (the calling thread is one of them). Returns when all tasks are done
+// If `num_threads` is 0, uses `pool_num_cores`
+// If there is an error, prints to stderr and exits
+void pool_run(
+	unsigned int num_threads,
+	const unsigned int num_tasks,
+	const pool_task_fn fn,
+	void *const data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
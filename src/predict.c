@@ -0,0 +1,441 @@
+#include "predict.h"
+
+#include <limits.h>
+#include <math.h>
+
+// Most wall bounces to follow when looking for bricks
+// Only a ball moving almost sideways needs more than a few
+#define PREDICT_MAX_LEGS 64
+
+// Room for rounding when looking bricks up by where they are,
+//  so that a brick that the ball only touches is still found
+#define PREDICT_HASH_SLACK 1.0
+
+// Fold `value` into [0, `room`] as if it bounced back and forth
+//  between 0 and `room`
+static double fold(const double value, const double room) {
+	if (room <= 0.0) {
+		return 0.0;
+	}
+
+	double folded = fmod(value, 2.0 * room);
+
+	if (folded < 0.0) {
+		folded += 2.0 * room;
+	}
+
+	if (folded > room) {
+		folded = 2.0 * room - folded;
+	}
+
+	return folded;
+}
+
+bool predict_crossing(
+	const struct game *const game,
+	const struct ball *const ball,
+	struct predict_crossing *const out)
+{
+	if (ball->vel_y == 0.0) {
+		return false;
+	}
+
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_top = game->play_area_origin_y
+		+ (game->play_area_size_y / 2.0);
+
+	// Value of the ball's `pos_y` when its bottom touches the paddle's top
+	const double cross_y = game->paddle.pos_y + ball->size_y;
+
+	double time;
+
+	if (ball->vel_y < 0.0) {
+		time = fmax((cross_y - ball->pos_y) / ball->vel_y, 0.0);
+	}
+	else {
+		// Up to the top wall, then back down at the same speed
+		time = fmax((play_area_top - ball->pos_y) / ball->vel_y, 0.0)
+			+ (play_area_top - cross_y) / ball->vel_y;
+	}
+
+	// How far the ball's left edge can go from the left wall
+	const double room = game->play_area_size_x - ball->size_x;
+
+	out->time = time;
+	out->x = play_area_left
+		+ fold(ball->pos_x - play_area_left + ball->vel_x * time, room);
+	out->brick = UINT_MAX;
+	out->brick_time = INFINITY;
+	out->brick_coll = COLL_NONE;
+
+	return true;
+}
+
+// A brick that the ball hits on a leg, and when
+struct leg_hit {
+	unsigned int brick;// UINT_MAX if none yet
+	double time;// Nanoseconds from the start of the leg
+	enum collision coll;
+};
+
+// Keep brick `b` in `hit` if the ball, starting the leg at (`pos_x`,
+//  `pos_y`), hits it within `leg_time` and before the brick in `hit`
+// Ties go to the lower index, so the order that bricks are tested in
+//  does not matter
+static void test_brick(
+	const struct game *const game,
+	const struct ball *const ball,
+	const unsigned int b,
+	const double pos_x,
+	const double pos_y,
+	const double vel_x,
+	const double vel_y,
+	const double leg_time,
+	struct leg_hit *const hit)
+{
+	if (game->brick_handles.dead[b]) {
+		return;
+	}
+
+	const struct brick *const brick = game->bricks[b];
+
+	double t;
+	enum collision coll;
+
+	const bool hits = collide_sweep(
+		brick->pos_x,
+		brick->pos_y,
+		brick->size_x,
+		brick->size_y,
+		pos_x,
+		pos_y,
+		ball->size_x,
+		ball->size_y,
+		vel_x,
+		vel_y,
+		&t,
+		&coll);
+
+	if (hits && t <= leg_time && (hit->brick == UINT_MAX
+		|| t < hit->time || (t == hit->time && b < hit->brick)))
+	{
+		hit->brick = b;
+		hit->time = t;
+		hit->coll = coll;
+	}
+}
+
+// Times between which [`pos`, `pos + size`], moving at `vel`,
+//  overlaps [`low`, `high`]
+// Returns false if it never does
+static bool overlap_times(
+	const double pos,
+	const double size,
+	const double vel,
+	const double low,
+	const double high,
+	double *const enter,
+	double *const exit)
+{
+	if (vel == 0.0) {
+		*enter = -INFINITY;
+		*exit = INFINITY;
+
+		return pos + size >= low && pos <= high;
+	}
+
+	const double a = (low - size - pos) / vel;
+	const double b = (high - pos) / vel;
+
+	*enter = fmin(a, b);
+	*exit = fmax(a, b);
+
+	return true;
+}
+
+// Test the bricks that `game.brick_hash` has along the leg, a cell's
+//  length of it at a time, until a hit is found before the next part
+static void find_leg_hit_hashed(
+	const struct game *const game,
+	const struct ball *const ball,
+	const double pos_x,
+	const double pos_y,
+	const double vel_x,
+	const double vel_y,
+	const double leg_time,
+	struct leg_hit *const hit)
+{
+	const struct rect_hash *const hash = &game->brick_hash;
+
+	if (hash->num_buckets == 0) {
+		return;
+	}
+
+	// Only while the ball is over the grid
+	double x_enter;
+	double x_exit;
+	double y_enter;
+	double y_exit;
+
+	if (!overlap_times(pos_x, ball->size_x, vel_x,
+			hash->origin_x - PREDICT_HASH_SLACK,
+			hash->origin_x + hash->num_columns * hash->cell_size
+				+ PREDICT_HASH_SLACK,
+			&x_enter, &x_exit)
+		|| !overlap_times(pos_y - ball->size_y, ball->size_y, vel_y,
+			hash->origin_y - PREDICT_HASH_SLACK,
+			hash->origin_y + hash->num_rows * hash->cell_size
+				+ PREDICT_HASH_SLACK,
+			&y_enter, &y_exit))
+	{
+		return;
+	}
+
+	const double start = fmax(0.0, fmax(x_enter, y_enter));
+	const double end = fmin(leg_time, fmin(x_exit, y_exit));
+
+	if (start > end) {
+		return;
+	}
+
+	// Time to move one cell. Infinite if the ball is still
+	const double part_time =
+		hash->cell_size / fmax(fabs(vel_x), fabs(vel_y));
+
+	for (double from = start; ; ) {
+		const double to = fmin(from + part_time, end);
+
+		// Box that the ball sweeps from `from` to `to`
+		const double from_x = pos_x + vel_x * from;
+		const double to_x = pos_x + vel_x * to;
+		const double from_y = pos_y + vel_y * from;
+		const double to_y = pos_y + vel_y * to;
+
+		int first_x;
+		int last_x;
+		int first_y;
+		int last_y;
+
+		if (rect_hash_cells(hash,
+			fmin(from_x, to_x) - PREDICT_HASH_SLACK,
+			fmax(from_x, to_x) + ball->size_x + PREDICT_HASH_SLACK,
+			fmin(from_y, to_y) - ball->size_y - PREDICT_HASH_SLACK,
+			fmax(from_y, to_y) + PREDICT_HASH_SLACK,
+			&first_x, &last_x, &first_y, &last_y))
+		{
+			for (int cell_y = first_y; cell_y <= last_y; cell_y += 1) {
+				for (int cell_x = first_x; cell_x <= last_x; cell_x += 1) {
+					const unsigned int bucket =
+						cell_y * hash->num_columns + cell_x;
+
+					for (unsigned int e = hash->bucket_starts[bucket];
+						e < hash->bucket_starts[bucket + 1]; e += 1)
+					{
+						const unsigned int r = hash->entries[e];
+
+						if (!rect_hash_owns(hash, r,
+							first_x, first_y, cell_x, cell_y))
+						{
+							continue;
+						}
+
+						// UINT_MAX if the brick is gone
+						const unsigned int b = handle_table_lookup(
+							&game->brick_handles, game->brick_hash_handles[r]);
+
+						if (b != UINT_MAX) {
+							test_brick(game, ball, b, pos_x, pos_y,
+								vel_x, vel_y, leg_time, hit);
+						}
+					}
+				}
+			}
+		}
+
+		// Any brick not tested yet is hit after `to`, if at all
+		if (to >= end || (hit->brick != UINT_MAX && hit->time <= to)) {
+			return;
+		}
+
+		from = to;
+	}
+}
+
+bool predict_first_brick(
+	const struct game *const game,
+	const struct ball *const ball,
+	const double max_time,
+	unsigned int *const out_brick,
+	double *const out_time,
+	enum collision *const out_coll)
+{
+	const double play_area_left = game->play_area_origin_x
+		- (game->play_area_size_x / 2.0);
+
+	const double play_area_right = game->play_area_origin_x
+		+ (game->play_area_size_x / 2.0);
+
+	const double play_area_top = game->play_area_origin_y
+		+ (game->play_area_size_y / 2.0);
+
+	double pos_x = ball->pos_x;
+	double pos_y = ball->pos_y;
+	double vel_x = ball->vel_x;
+	double vel_y = ball->vel_y;
+	double elapsed = 0.0;
+
+	// Each leg is a straight line that ends at a wall or at `max_time`
+	for (unsigned int leg = 0; leg < PREDICT_MAX_LEGS; leg += 1) {
+		const double remaining = max_time - elapsed;
+
+		if (remaining <= 0.0) {
+			return false;
+		}
+
+		double wall_x_time = INFINITY;
+		double wall_y_time = INFINITY;
+
+		if (vel_x < 0.0) {
+			wall_x_time = fmax((play_area_left - pos_x) / vel_x, 0.0);
+		}
+		else if (vel_x > 0.0) {
+			wall_x_time = fmax(
+				(play_area_right - ball->size_x - pos_x) / vel_x, 0.0);
+		}
+
+		if (vel_y > 0.0) {
+			wall_y_time = fmax((play_area_top - pos_y) / vel_y, 0.0);
+		}
+
+		const double leg_time =
+			fmin(remaining, fmin(wall_x_time, wall_y_time));
+
+		struct leg_hit hit = {.brick = UINT_MAX};
+
+		if (game->bricks_hashed) {
+			find_leg_hit_hashed(game, ball, pos_x, pos_y, vel_x, vel_y,
+				leg_time, &hit);
+		}
+		else {
+			for (unsigned int b = 0; b < game->num_bricks; b += 1) {
+				test_brick(game, ball, b, pos_x, pos_y, vel_x, vel_y,
+					leg_time, &hit);
+			}
+		}
+
+		if (hit.brick != UINT_MAX) {
+			*out_brick = hit.brick;
+			*out_time = elapsed + hit.time;
+			*out_coll = hit.coll;
+
+			return true;
+		}
+
+		pos_x += vel_x * leg_time;
+		pos_y += vel_y * leg_time;
+		elapsed += leg_time;
+
+		if (leg_time == wall_x_time) {
+			vel_x = -vel_x;
+		}
+
+		if (leg_time == wall_y_time) {
+			vel_y = -vel_y;
+		}
+	}
+
+	return false;
+}
+
+bool predict_crossing_with_bricks(
+	const struct game *const game,
+	const struct ball *const ball,
+	struct predict_crossing *const out)
+{
+	if (!predict_crossing(game, ball, out)) {
+		return false;
+	}
+
+	unsigned int brick;
+	double time;
+	enum collision coll;
+
+	if (predict_first_brick(game, ball, out->time, &brick, &time, &coll)) {
+		out->brick = brick;
+		out->brick_time = time;
+		out->brick_coll = coll;
+	}
+
+	return true;
+}
+
+bool predict_catch(
+	const struct game *const game,
+	double *const out_paddle_x,
+	double *const out_time)
+{
+	// Earliest crossing overall, and earliest with no brick in the way
+	unsigned int any_ball = UINT_MAX;
+	struct predict_crossing any;
+	unsigned int clear_ball = UINT_MAX;
+	struct predict_crossing clear;
+
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		if (game->ball_handles.dead[i]) {
+			continue;
+		}
+
+		struct predict_crossing crossing;
+
+		if (!predict_crossing_with_bricks(game, game->balls[i], &crossing)) {
+			continue;
+		}
+
+		if (any_ball == UINT_MAX || crossing.time < any.time) {
+			any_ball = i;
+			any = crossing;
+		}
+
+		if (crossing.brick == UINT_MAX &&
+		    (clear_ball == UINT_MAX || crossing.time < clear.time))
+		{
+			clear_ball = i;
+			clear = crossing;
+		}
+	}
+
+	if (any_ball == UINT_MAX) {
+		return false;
+	}
+
+	const unsigned int ball = (clear_ball != UINT_MAX) ? clear_ball : any_ball;
+	const struct predict_crossing *const crossing =
+		(clear_ball != UINT_MAX) ? &clear : &any;
+
+	*out_paddle_x = crossing->x + (game->balls[ball]->size_x / 2.0)
+		- (game->paddle.size_x / 2.0);
+	*out_time = crossing->time;
+
+	return true;
+}
+
+double predict_control_paddle(struct game *const game, const uint64_t delta) {
+	double target_x;
+	double time;
+
+	if (!predict_catch(game, &target_x, &time)) {
+		return 0.0;
+	}
+
+	// Cover the same fraction of the distance as of the time left,
+	//  so the paddle arrives as the ball does
+	double move = target_x - game->paddle.pos_x;
+
+	if (time > (double)delta) {
+		move *= (double)delta / time;
+	}
+
+	return game_move_paddle(game, game->paddle.pos_x + move);
+}
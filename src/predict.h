@@ -0,0 +1,74 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+// Analytic prediction of ball paths, and a paddle controller built on it
+// Bounces off of the walls are unfolded instead of stepped,
+//  so the cost does not depend on how fast the balls move
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Where and when a ball's bottom reaches the top of the paddle
+struct predict_crossing {
+	double time;// Nanoseconds from now. 0 if the ball is already below
+	double x;// Ball's left edge at that time
+	// First brick the ball hits before then, or UINT_MAX if none.
+	// If there is one, the crossing will not happen as predicted
+	unsigned int brick;
+	double brick_time;// Nanoseconds from now. Only valid with `brick`
+	enum collision brick_coll;
+};
+
+// Predict where `ball` crosses the top of the paddle,
+//  bouncing off of the side walls and the top wall on the way
+// Returns false if the ball does not move vertically
+// Does not look for bricks (`brick` is set to UINT_MAX). O(1)
+bool predict_crossing(
+	const struct game *const game,
+	const struct ball *const ball,
+	struct predict_crossing *const out);
+
+// Find the first live brick that `ball` hits within `max_time` ns,
+//  following its bounces off of the walls
+// Only tests the bricks that `game.brick_hash` has along the way,
+//  or every brick while `game.bricks_hashed` is false
+// Returns false if none. Otherwise sets `out_brick`, `out_time`, `out_coll`
+bool predict_first_brick(
+	const struct game *const game,
+	const struct ball *const ball,
+	const double max_time,
+	unsigned int *const out_brick,
+	double *const out_time,
+	enum collision *const out_coll);
+
+// Same as `predict_crossing` but also fills in the first brick hit
+bool predict_crossing_with_bricks(
+	const struct game *const game,
+	const struct ball *const ball,
+	struct predict_crossing *const out);
+
+// Choose the ball to catch next and where the paddle's left edge
+//  should be (so that the ball lands on the middle of the paddle)
+// Prefers the earliest crossing that no brick is in the way of
+// Returns false if there is no live ball moving vertically
+bool predict_catch(
+	const struct game *const game,
+	double *const out_paddle_x,
+	double *const out_time);
+
+// Move the paddle for one step of `delta` ns so that it gets to
+//  `predict_catch`'s target just in time, at whatever speed that takes
+// Returns how far the paddle moved (pass it on as `paddle_dx`)
+double predict_control_paddle(struct game *const game, const uint64_t delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -17,3 +17,44 @@ int rand_int(const int min, const int max) {
 
 	return min + (rand() % (range + 1));
 }
+
+void rand_state_seed(struct rand_state *const state, const uint64_t seed) {
+	// splitmix64 so that nearby seeds give unrelated states
+	uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	z = z ^ (z >> 31);
+
+	// xorshift must not start at 0
+	state->s = (z == 0) ? 1 : z;
+}
+
+uint32_t rand_state_next(struct rand_state *const state) {
+	uint64_t x = state->s;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	state->s = x;
+
+	return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+double rand_state_double01(struct rand_state *const state) {
+	return ((double)rand_state_next(state)) / ((double)UINT32_MAX);
+}
+
+double rand_state_double(
+	struct rand_state *const state,
+	const double min,
+	const double max)
+{
+	const double range = max - min;
+
+	return min + (rand_state_double01(state) * range);
+}
+
+int rand_state_int(struct rand_state *const state, const int min, const int max) {
+	const uint32_t range = (uint32_t)(max - min) + 1;
+
+	return min + (int)(rand_state_next(state) % range);
+}
@@ -1,6 +1,8 @@
 #ifndef RAND_H
 #define RAND_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +17,30 @@ double rand_double(const double min, const double max);
 // Return a random int in range [min, max] (both inclusive)
 int rand_int(const int min, const int max);
 
+// Generator with its own state (xorshift64*), for when `rand` will not do:
+//  each game has one so that many games can run on many threads
+//  and still play out the same as when run one at a time
+struct rand_state {
+	uint64_t s;
+};
+
+// Any seed is fine, including 0
+void rand_state_seed(struct rand_state *const state, const uint64_t seed);
+
+// Return a random 32-bit value
+uint32_t rand_state_next(struct rand_state *const state);
+
+// Same as the functions above, but using `state` instead of `rand`
+
+double rand_state_double01(struct rand_state *const state);
+
+double rand_state_double(
+	struct rand_state *const state,
+	const double min,
+	const double max);
+
+int rand_state_int(struct rand_state *const state, const int min, const int max);
+
 #ifdef __cplusplus
 }
 #endif
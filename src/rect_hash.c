@@ -0,0 +1,248 @@
+#include "rect_hash.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "easy_alloc.h"
+
+// Fewest buckets, so that a few rects still get a grid
+#define RECT_HASH_MIN_BUCKETS 256
+// The grid of a build has at most this many cells per rect,
+//  with bigger cells if needed
+#define RECT_HASH_BUCKETS_PER_RECT 8
+
+void rect_hash_init(struct rect_hash *const hash, const game_scalar cell_size) {
+	hash->min_cell_size = cell_size;
+	hash->cell_size = cell_size;
+	hash->cells_per_unit = 1.0 / cell_size;
+
+	hash->origin_x = 0.0;
+	hash->origin_y = 0.0;
+	hash->num_columns = 0;
+	hash->num_rows = 0;
+
+	hash->num_buckets = 0;
+	hash->buckets_len = RECT_HASH_MIN_BUCKETS + 1;
+	hash->bucket_starts = easy_malloc(sizeof(unsigned int) * hash->buckets_len);
+
+	hash->rects_len = 64;
+	hash->num_rects = 0;
+	hash->rects = easy_malloc(sizeof(struct rect_hash_rect) * hash->rects_len);
+	hash->first_columns = easy_malloc(sizeof(int) * hash->rects_len);
+	hash->first_rows = easy_malloc(sizeof(int) * hash->rects_len);
+
+	hash->entries_len = 256;
+	hash->num_entries = 0;
+	hash->entries = easy_malloc(sizeof(unsigned int) * hash->entries_len);
+}
+
+void rect_hash_deinit(struct rect_hash *const hash) {
+	easy_free(hash->bucket_starts);
+	easy_free(hash->rects);
+	easy_free(hash->first_columns);
+	easy_free(hash->first_rows);
+	easy_free(hash->entries);
+}
+
+// Most cells the grid may have for `num` rects
+static unsigned int max_grid_buckets(const unsigned int num) {
+	const unsigned int buckets = num * RECT_HASH_BUCKETS_PER_RECT;
+
+	return buckets > RECT_HASH_MIN_BUCKETS ? buckets : RECT_HASH_MIN_BUCKETS;
+}
+
+static void reserve_rects(struct rect_hash *const hash, const unsigned int num) {
+	if (num > hash->rects_len) {
+		while (num > hash->rects_len) {
+			hash->rects_len *= 2;
+		}
+
+		hash->rects = easy_realloc(hash->rects,
+			sizeof(struct rect_hash_rect) * hash->rects_len);
+		hash->first_columns = easy_realloc(hash->first_columns,
+			sizeof(int) * hash->rects_len);
+		hash->first_rows = easy_realloc(hash->first_rows,
+			sizeof(int) * hash->rects_len);
+	}
+
+	const unsigned int max_buckets = max_grid_buckets(num);
+
+	if (max_buckets + 1 > hash->buckets_len) {
+		hash->buckets_len = max_buckets + 1;
+		hash->bucket_starts = easy_realloc(hash->bucket_starts,
+			sizeof(unsigned int) * hash->buckets_len);
+	}
+}
+
+static void reserve_entries(
+	struct rect_hash *const hash,
+	const unsigned int num)
+{
+	if (num > hash->entries_len) {
+		while (num > hash->entries_len) {
+			hash->entries_len *= 2;
+		}
+
+		hash->entries = easy_realloc(hash->entries,
+			sizeof(unsigned int) * hash->entries_len);
+	}
+}
+
+void rect_hash_reserve(
+	struct rect_hash *const hash,
+	const unsigned int num,
+	const game_scalar max_size_x,
+	const game_scalar max_size_y)
+{
+	reserve_rects(hash, num);
+
+	// Cells are never smaller than `min_cell_size`, and a rect is in
+	//  at most one more column and row than it spans whole cells
+	const unsigned int columns = max_size_x / hash->min_cell_size + 2.0;
+	const unsigned int rows = max_size_y / hash->min_cell_size + 2.0;
+
+	reserve_entries(hash, num * columns * rows);
+}
+
+void rect_hash_resize(struct rect_hash *const hash, const unsigned int num) {
+	reserve_rects(hash, num);
+	hash->num_rects = num;
+}
+
+// Place the grid over the box, with cells as small as `min_cell_size`
+//  allows for `max_buckets` of them
+static void place_grid(
+	struct rect_hash *const hash,
+	const game_scalar min_x,
+	const game_scalar max_x,
+	const game_scalar min_y,
+	const game_scalar max_y,
+	const unsigned int max_buckets)
+{
+	game_scalar cell_size = hash->min_cell_size;
+
+	while (true) {
+		// Whole cells from a multiple of the cell size, so that the
+		//  grid does not shift when the box changes a little
+		const game_scalar origin_x = floor(min_x / cell_size) * cell_size;
+		const game_scalar origin_y = floor(min_y / cell_size) * cell_size;
+
+		const double columns = floor((max_x - origin_x) / cell_size) + 1.0;
+		const double rows = floor((max_y - origin_y) / cell_size) + 1.0;
+
+		if (columns * rows <= max_buckets) {
+			hash->cell_size = cell_size;
+			hash->cells_per_unit = 1.0 / cell_size;
+			hash->origin_x = origin_x;
+			hash->origin_y = origin_y;
+			hash->num_columns = columns;
+			hash->num_rows = rows;
+			hash->num_buckets = hash->num_columns * hash->num_rows;
+
+			return;
+		}
+
+		cell_size *= 2.0;
+	}
+}
+
+void rect_hash_build(struct rect_hash *const hash) {
+	const unsigned int num = hash->num_rects;
+
+	if (num == 0) {
+		hash->num_columns = 0;
+		hash->num_rows = 0;
+		hash->num_buckets = 0;
+		hash->num_entries = 0;
+
+		return;
+	}
+
+	// Bounding box of the rects
+	game_scalar min_x = hash->rects[0].pos_x;
+	game_scalar max_x = hash->rects[0].pos_x + hash->rects[0].size_x;
+	game_scalar min_y = hash->rects[0].pos_y - hash->rects[0].size_y;
+	game_scalar max_y = hash->rects[0].pos_y;
+
+	for (unsigned int r = 1; r < num; r += 1) {
+		const struct rect_hash_rect *const rect = &hash->rects[r];
+
+		if (rect->pos_x < min_x) min_x = rect->pos_x;
+		if (rect->pos_x + rect->size_x > max_x) max_x = rect->pos_x + rect->size_x;
+		if (rect->pos_y - rect->size_y < min_y) min_y = rect->pos_y - rect->size_y;
+		if (rect->pos_y > max_y) max_y = rect->pos_y;
+	}
+
+	place_grid(hash, min_x, max_x, min_y, max_y, max_grid_buckets(num));
+
+	unsigned int *const starts = hash->bucket_starts;
+	memset(starts, 0, sizeof(unsigned int) * (hash->num_buckets + 1));
+
+	// Count the rects in each bucket
+	unsigned int num_entries = 0;
+
+	for (unsigned int r = 0; r < num; r += 1) {
+		const struct rect_hash_rect *const rect = &hash->rects[r];
+
+		// The grid was made to fit the rects, so this only catches rounding
+		int first_x = rect_hash_cell(hash, rect->pos_x, hash->origin_x);
+		int last_x = rect_hash_cell(hash,
+			rect->pos_x + rect->size_x, hash->origin_x);
+		int first_y = rect_hash_cell(hash,
+			rect->pos_y - rect->size_y, hash->origin_y);
+		int last_y = rect_hash_cell(hash, rect->pos_y, hash->origin_y);
+
+		if (first_x < 0) first_x = 0;
+		if (first_y < 0) first_y = 0;
+		if (last_x >= hash->num_columns) last_x = hash->num_columns - 1;
+		if (last_y >= hash->num_rows) last_y = hash->num_rows - 1;
+
+		hash->first_columns[r] = first_x;
+		hash->first_rows[r] = first_y;
+
+		for (int y = first_y; y <= last_y; y += 1) {
+			for (int x = first_x; x <= last_x; x += 1) {
+				starts[y * hash->num_columns + x] += 1;
+			}
+		}
+
+		num_entries += (last_x - first_x + 1) * (last_y - first_y + 1);
+	}
+
+	reserve_entries(hash, num_entries);
+	hash->num_entries = num_entries;
+
+	// Now `starts[b]` is the end of bucket b
+	unsigned int total = 0;
+
+	for (unsigned int b = 0; b < hash->num_buckets; b += 1) {
+		total += starts[b];
+		starts[b] = total;
+	}
+
+	starts[hash->num_buckets] = num_entries;
+
+	// Fill each bucket from its end. Going backwards keeps the rects
+	//  of a bucket in order and leaves `starts[b]` at the start of b
+	for (unsigned int r = num; r > 0; r -= 1) {
+		const struct rect_hash_rect *const rect = &hash->rects[r - 1];
+
+		const int first_x = hash->first_columns[r - 1];
+		const int first_y = hash->first_rows[r - 1];
+		int last_x = rect_hash_cell(hash,
+			rect->pos_x + rect->size_x, hash->origin_x);
+		int last_y = rect_hash_cell(hash, rect->pos_y, hash->origin_y);
+
+		if (last_x >= hash->num_columns) last_x = hash->num_columns - 1;
+		if (last_y >= hash->num_rows) last_y = hash->num_rows - 1;
+
+		for (int y = first_y; y <= last_y; y += 1) {
+			for (int x = first_x; x <= last_x; x += 1) {
+				const unsigned int bucket = y * hash->num_columns + x;
+
+				starts[bucket] -= 1;
+				hash->entries[starts[bucket]] = r - 1;
+			}
+		}
+	}
+}
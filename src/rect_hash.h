@@ -0,0 +1,158 @@
+#ifndef RECT_HASH_H
+#define RECT_HASH_H
+
+// Spatial hash of rects for finding the ones near a small moving box,
+//  such as the bricks and the paddle that a particle might hit
+// Each rect goes in the bucket of every grid cell that it overlaps, and
+//  a counting sort puts the rects of each bucket next to each other in
+//  the order they were added: two passes over the rects and one over the
+//  buckets, with no allocation once the arrays are big enough.
+// There is one bucket per cell of a grid over the rects' bounding box,
+//  row by row, so no two cells share one. The rects hardly change, so
+//  the hash is small next to the things looked up in it, and stays in
+//  the cache while those are gone through once in their own order.
+// A box looks in every cell that it overlaps and finds a rect in each
+//  of those that the rect is in too. `rect_hash_owns` picks one of them
+//  so that each rect is tested once.
+
+#include <stdbool.h>
+
+#include "game_scalar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// As in game.h: `pos` is the top left
+struct rect_hash_rect {
+	game_scalar pos_x;
+	game_scalar pos_y;
+	game_scalar size_x;
+	game_scalar size_y;
+};
+
+struct rect_hash {
+	game_scalar min_cell_size;// As passed to `rect_hash_init`
+	game_scalar cell_size;// Of the last build. At least `min_cell_size`
+	game_scalar cells_per_unit;// 1 / `cell_size`
+
+	// Grid of the last build. Cell (0, 0) is the one with the
+	//  bottom left of the rects' bounding box in it
+	game_scalar origin_x;
+	game_scalar origin_y;
+	int num_columns;
+	int num_rows;
+
+	unsigned int num_buckets;// `num_columns * num_rows`
+	unsigned int buckets_len;// Allocated length of `bucket_starts`
+	// Bucket b is `entries[bucket_starts[b]]` up to but not including
+	//  `entries[bucket_starts[b + 1]]`. Bucket of column x of row y is
+	//  `y * num_columns + x`
+	unsigned int *bucket_starts;
+
+	// Filled in by the caller before `rect_hash_build`
+	unsigned int rects_len;// Allocated length of the per-rect arrays
+	unsigned int num_rects;
+	struct rect_hash_rect *rects;
+	// Per rect. First column and row of the cells it is in
+	int *first_columns;
+	int *first_rows;
+
+	unsigned int entries_len;// Allocated length of `entries`
+	unsigned int num_entries;
+	// Indices of rects, by bucket, and in rect order within one
+	unsigned int *entries;
+};
+
+void rect_hash_init(struct rect_hash *const hash, const game_scalar cell_size);
+
+void rect_hash_deinit(struct rect_hash *const hash);
+
+// Make room for `num` rects of up to `max_size_x` by `max_size_y`,
+//  so that building a hash of as many rects as big or smaller does
+//  not allocate
+void rect_hash_reserve(
+	struct rect_hash *const hash,
+	const unsigned int num,
+	const game_scalar max_size_x,
+	const game_scalar max_size_y);
+
+// Make `num` rects for the caller to fill in in `hash->rects`
+void rect_hash_resize(struct rect_hash *const hash, const unsigned int num);
+
+// Hash the rects in `hash->rects`
+void rect_hash_build(struct rect_hash *const hash);
+
+// Column or row of the cell that `coord` is in, counting from `origin`
+// Not clamped to the grid
+static inline int rect_hash_cell(
+	const struct rect_hash *const hash,
+	const game_scalar coord,
+	const game_scalar origin)
+{
+	const game_scalar cells = (coord - origin) * hash->cells_per_unit;
+
+	// Round down. Casting rounds towards 0
+	const int cell = (int)cells;
+	return cell - (cells < cell);
+}
+
+// Columns and rows of the cells that overlap the box, clamped to the grid
+// Returns false if the box misses the grid, so it overlaps no rect
+static inline bool rect_hash_cells(
+	const struct rect_hash *const hash,
+	const game_scalar left,
+	const game_scalar right,
+	const game_scalar bottom,
+	const game_scalar top,
+	int *const first_x,
+	int *const last_x,
+	int *const first_y,
+	int *const last_y)
+{
+	if (hash->num_buckets == 0) {
+		return false;
+	}
+
+	*first_x = rect_hash_cell(hash, left, hash->origin_x);
+	*last_x = rect_hash_cell(hash, right, hash->origin_x);
+	*first_y = rect_hash_cell(hash, bottom, hash->origin_y);
+	*last_y = rect_hash_cell(hash, top, hash->origin_y);
+
+	if (*last_x < 0 || *first_x >= hash->num_columns
+		|| *last_y < 0 || *first_y >= hash->num_rows)
+	{
+		return false;
+	}
+
+	if (*first_x < 0) *first_x = 0;
+	if (*first_y < 0) *first_y = 0;
+	if (*last_x >= hash->num_columns) *last_x = hash->num_columns - 1;
+	if (*last_y >= hash->num_rows) *last_y = hash->num_rows - 1;
+
+	return true;
+}
+
+// Whether a box with cells from (`first_x`, `first_y`), looking in cell
+//  (`cell_x`, `cell_y`), is the one to test rect `r` found there:
+//  the first of the cells that both are in
+static inline bool rect_hash_owns(
+	const struct rect_hash *const hash,
+	const unsigned int r,
+	const int first_x,
+	const int first_y,
+	const int cell_x,
+	const int cell_y)
+{
+	const int rect_x = hash->first_columns[r];
+	const int rect_y = hash->first_rows[r];
+
+	return cell_x == (rect_x > first_x ? rect_x : first_x)
+		&& cell_y == (rect_y > first_y ? rect_y : first_y);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "easy_alloc.h"
+#include "predict.h"
+
+// First line of every replay file
+#define REPLAY_MAGIC "break-bricks replay 1"
+
+#define REPLAY_MAX_LINE 256
+
+void replay_init(struct replay *const replay, const uint64_t seed) {
+	replay->seed = seed;
+	replay->len = 1024;
+	replay->steps = easy_malloc(sizeof(struct replay_step) * replay->len);
+	replay->num_steps = 0;
+	replay->end_hash = 0;
+}
+
+void replay_deinit(struct replay *const replay) {
+	easy_free(replay->steps);
+}
+
+void replay_append(
+	struct replay *const replay,
+	const struct replay_step *const step)
+{
+	if (replay->num_steps == replay->len) {
+		replay->len *= 2;
+		replay->steps = easy_realloc(replay->steps,
+			sizeof(struct replay_step) * replay->len);
+	}
+
+	replay->steps[replay->num_steps] = *step;
+	replay->num_steps += 1;
+}
+
+static void scale_ball_speeds(struct game *const game, const double factor) {
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		struct ball *const ball = game->balls[i];
+
+		ball->vel_x *= factor;
+		ball->vel_y *= factor;
+	}
+}
+
+double replay_apply(
+	struct game *const game,
+	const struct replay_step *const step)
+{
+	for (unsigned int i = 0; i < step->num_speed_ups; i += 1) {
+		scale_ball_speeds(game, 2.0);
+	}
+
+	for (unsigned int i = 0; i < step->num_speed_downs; i += 1) {
+		scale_ball_speeds(game, 0.5);
+	}
+
+	if (step->reset) {
+		game_setup(game);
+	}
+
+	if (step->ai_paddle) {
+		return predict_control_paddle(game, step->delta);
+	}
+
+	if (step->paddle_x != REPLAY_NO_PADDLE) {
+		return game_move_paddle(game, step->paddle_x);
+	}
+
+	return 0.0;
+}
+
+// FNV-1a over the bytes of `value`
+static uint64_t hash_double(uint64_t hash, const double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	for (unsigned int i = 0; i < 8; i += 1) {
+		hash ^= (bits >> (8 * i)) & 0xff;
+		hash *= 1099511628211u;
+	}
+
+	return hash;
+}
+
+uint64_t replay_hash(const struct game *const game) {
+	uint64_t hash = 14695981039346656037u;
+
+	hash = hash_double(hash, game->paddle.pos_x);
+
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		hash = hash_double(hash, game->balls[i]->pos_x);
+		hash = hash_double(hash, game->balls[i]->pos_y);
+	}
+
+	for (unsigned int i = 0; i < game->num_bricks; i += 1) {
+		hash = hash_double(hash, game->bricks[i]->pos_x);
+		hash = hash_double(hash, game->bricks[i]->pos_y);
+	}
+
+	return hash;
+}
+
+void replay_write(const struct replay *const replay, const char *const path) {
+	FILE *const file = fopen(path, "w");
+
+	if (file == NULL) {
+		fprintf(stderr, "%s: Failed to open %s for writing\n", __func__, path);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(file, "%s\n", REPLAY_MAGIC);
+	fprintf(file, "seed %lu\n", (unsigned long)replay->seed);
+	fprintf(file, "end_hash %lu\n", (unsigned long)replay->end_hash);
+	fprintf(file, "steps %u\n", replay->num_steps);
+
+	// The delta, then only what happened
+	for (unsigned int i = 0; i < replay->num_steps; i += 1) {
+		const struct replay_step *const step = &replay->steps[i];
+
+		fprintf(file, "%lu", (unsigned long)step->delta);
+
+		if (step->paddle_x != REPLAY_NO_PADDLE) {
+			fprintf(file, " x=%d", step->paddle_x);
+		}
+
+		if (step->ai_paddle) {
+			fprintf(file, " ai");
+		}
+
+		if (step->reset) {
+			fprintf(file, " reset");
+		}
+
+		for (unsigned int k = 0; k < step->num_speed_ups; k += 1) {
+			fprintf(file, " up");
+		}
+
+		for (unsigned int k = 0; k < step->num_speed_downs; k += 1) {
+			fprintf(file, " down");
+		}
+
+		fprintf(file, "\n");
+	}
+
+	if (fclose(file) != 0) {
+		fprintf(stderr, "%s: Failed to write %s\n", __func__, path);
+		exit(EXIT_FAILURE);
+	}
+}
+
+// Prints to stderr and exits
+static void bad_line(
+	const char *const path,
+	const unsigned int line_number,
+	const char *const what)
+{
+	fprintf(stderr, "replay_read: %s:%u: %s\n", path, line_number, what);
+	exit(EXIT_FAILURE);
+}
+
+void replay_read(struct replay *const replay, const char *const path) {
+	FILE *const file = fopen(path, "r");
+
+	if (file == NULL) {
+		fprintf(stderr, "%s: Failed to open %s\n", __func__, path);
+		exit(EXIT_FAILURE);
+	}
+
+	char line[REPLAY_MAX_LINE];
+	unsigned long seed;
+	unsigned long end_hash;
+	unsigned int num_steps;
+
+	if (fgets(line, sizeof(line), file) == NULL
+		|| strncmp(line, REPLAY_MAGIC, strlen(REPLAY_MAGIC)) != 0)
+	{
+		bad_line(path, 1, "Not a replay");
+	}
+
+	if (fgets(line, sizeof(line), file) == NULL
+		|| sscanf(line, "seed %lu", &seed) != 1)
+	{
+		bad_line(path, 2, "Expected seed");
+	}
+
+	if (fgets(line, sizeof(line), file) == NULL
+		|| sscanf(line, "end_hash %lu", &end_hash) != 1)
+	{
+		bad_line(path, 3, "Expected end_hash");
+	}
+
+	if (fgets(line, sizeof(line), file) == NULL
+		|| sscanf(line, "steps %u", &num_steps) != 1)
+	{
+		bad_line(path, 4, "Expected steps");
+	}
+
+	replay_init(replay, seed);
+	replay->end_hash = end_hash;
+
+	unsigned int line_number = 4;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		line_number += 1;
+
+		struct replay_step step = {
+			.paddle_x = REPLAY_NO_PADDLE
+		};
+
+		char *token = strtok(line, " \n");
+		char *end;
+
+		if (token == NULL) {
+			bad_line(path, line_number, "Empty line");
+		}
+
+		step.delta = strtoull(token, &end, 10);
+
+		if (end == token || *end != '\0') {
+			bad_line(path, line_number, "Expected a delta");
+		}
+
+		while ((token = strtok(NULL, " \n")) != NULL) {
+			if (strncmp(token, "x=", 2) == 0) {
+				step.paddle_x = strtol(token + 2, &end, 10);
+
+				if (end == token + 2 || *end != '\0') {
+					bad_line(path, line_number, "Bad paddle x");
+				}
+			}
+			else if (strcmp(token, "ai") == 0) {
+				step.ai_paddle = true;
+			}
+			else if (strcmp(token, "reset") == 0) {
+				step.reset = true;
+			}
+			else if (strcmp(token, "up") == 0) {
+				step.num_speed_ups += 1;
+			}
+			else if (strcmp(token, "down") == 0) {
+				step.num_speed_downs += 1;
+			}
+			else {
+				bad_line(path, line_number, "Unknown input");
+			}
+		}
+
+		replay_append(replay, &step);
+	}
+
+	fclose(file);
+
+	if (replay->num_steps != num_steps) {
+		fprintf(stderr, "%s: %s has %u steps instead of %u\n",
+			__func__, path, replay->num_steps, num_steps);
+		exit(EXIT_FAILURE);
+	}
+}
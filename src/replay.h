@@ -0,0 +1,68 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Record the input of every step of a game so that it can be played
+//  again without a window (see `--replay` in sim/sim.c)
+// Games are deterministic given their seed, so the seed and the input
+//  of each step are all that is needed. The file also holds a hash of
+//  the game at the end to check that the replay played out the same.
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// `replay_step.paddle_x` when the mouse did not move
+#define REPLAY_NO_PADDLE INT_MIN
+
+// What the sim thread applied before one `game_step`
+struct replay_step {
+	uint64_t delta;
+	int paddle_x;// Wanted left edge of the paddle, or REPLAY_NO_PADDLE
+	bool ai_paddle;// Paddle moved by predict.h instead
+	bool reset;
+	uint8_t num_speed_ups;
+	uint8_t num_speed_downs;
+};
+
+struct replay {
+	uint64_t seed;// Passed to `game_seed` before the first `game_setup`
+	unsigned int len;// Allocated length of `steps`
+	struct replay_step *steps;
+	unsigned int num_steps;
+	uint64_t end_hash;// `replay_hash` of the game after the last step
+};
+
+void replay_init(struct replay *const replay, const uint64_t seed);
+
+void replay_deinit(struct replay *const replay);
+
+void replay_append(
+	struct replay *const replay,
+	const struct replay_step *const step);
+
+// Apply `step` to `game`: speed changes, reset, then the paddle
+// Returns how far the paddle moved (pass it on as `paddle_dx`)
+double replay_apply(
+	struct game *const game,
+	const struct replay_step *const step);
+
+// Hash of the positions of the balls, bricks, and paddle
+uint64_t replay_hash(const struct game *const game);
+
+// Text, one line per step. If error, print to stderr and exit
+void replay_write(const struct replay *const replay, const char *const path);
+
+// `replay` must not be initialized. If error, print to stderr and exit
+void replay_read(struct replay *const replay, const char *const path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -244,6 +244,20 @@ void sdlu_render_fill_rect(
 	}
 }
 
+void sdlu_render_fill_frect(
+	SDL_Renderer *renderer,
+	const SDL_FRect *rect)
+{
+	const int code = SDL_RenderFillRectF(renderer, rect);
+
+	if (code != 0) {
+		fprintf(stderr, "%s: SDL_RenderFillRectF error code: %d: %s\n",
+			__func__, code, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+}
+
 void sdlu_render_clear(SDL_Renderer *renderer) {
 	const int code = SDL_RenderClear(renderer);
 
@@ -270,6 +284,35 @@ SDL_Texture *sdlu_create_texture_from_surface(
 	return tex;
 }
 
+SDL_Texture *sdlu_create_texture(
+	SDL_Renderer *renderer,
+	uint32_t format,
+	int access,
+	int w,
+	int h)
+{
+	SDL_Texture *const tex = SDL_CreateTexture(renderer, format, access, w, h);
+
+	if (tex == NULL) {
+		fprintf(stderr, "%s: Error: %s\n", __func__, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+
+	return tex;
+}
+
+void sdlu_set_render_target(SDL_Renderer *renderer, SDL_Texture *texture) {
+	const int code = SDL_SetRenderTarget(renderer, texture);
+
+	if (code != 0) {
+		fprintf(stderr, "%s: Error: %d: %s\n",
+			__func__, code, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+}
+
 void sdlu_render_copy(
 	SDL_Renderer *renderer,
 	SDL_Texture *texture,
@@ -303,6 +346,49 @@ void sdlu_query_texture(
 	}
 }
 
+SDL_Surface *sdlu_create_rgb_surface_with_format(
+	int w,
+	int h,
+	uint32_t format)
+{
+	SDL_Surface *const surface =
+		SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+
+	if (surface == NULL) {
+		fprintf(stderr, "%s: Error: %s\n", __func__, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+
+	return surface;
+}
+
+SDL_Surface *sdlu_convert_surface_format(
+	SDL_Surface *surface,
+	uint32_t format)
+{
+	SDL_Surface *const converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+
+	if (converted == NULL) {
+		fprintf(stderr, "%s: Error: %s\n", __func__, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+
+	return converted;
+}
+
+void sdlu_lock_surface(SDL_Surface *surface) {
+	const int code = SDL_LockSurface(surface);
+
+	if (code != 0) {
+		fprintf(stderr, "%s: Error: %d: %s\n",
+			__func__, code, SDL_GetError());
+
+		exit(EXIT_FAILURE);
+	}
+}
+
 int sdlu_show_cursor(int toggle) {
 	const int code = SDL_ShowCursor(toggle);
 
@@ -86,12 +86,27 @@ void sdlu_render_fill_rect(
 	SDL_Renderer *renderer,
 	const SDL_Rect *rect);
 
+// Requires SDL 2.0.10
+void sdlu_render_fill_frect(
+	SDL_Renderer *renderer,
+	const SDL_FRect *rect);
+
 void sdlu_render_clear(SDL_Renderer *renderer);
 
 SDL_Texture *sdlu_create_texture_from_surface(
 	SDL_Renderer *renderer,
 	SDL_Surface *surface);
 
+SDL_Texture *sdlu_create_texture(
+	SDL_Renderer *renderer,
+	uint32_t format,
+	int access,
+	int w,
+	int h);
+
+// Pass NULL for `texture` to render to the window again
+void sdlu_set_render_target(SDL_Renderer *renderer, SDL_Texture *texture);
+
 void sdlu_render_copy(
 	SDL_Renderer *renderer,
 	SDL_Texture *texture,
@@ -105,6 +120,20 @@ void sdlu_query_texture(
 	int *w,
 	int *h);
 
+// If error, print and exit
+SDL_Surface *sdlu_create_rgb_surface_with_format(
+	int w,
+	int h,
+	uint32_t format);
+
+// Returns a new surface. If error, print and exit
+SDL_Surface *sdlu_convert_surface_format(
+	SDL_Surface *surface,
+	uint32_t format);
+
+// If error, print and exit
+void sdlu_lock_surface(SDL_Surface *surface);
+
 int sdlu_show_cursor(int toggle);
 
 #ifdef __cplusplus
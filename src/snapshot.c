@@ -0,0 +1,324 @@
+#include "snapshot.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "easy_alloc.h"
+#include "nsec.h"
+
+// Bit set in `snapshot_buffer.middle` when it holds a new snapshot
+#define SNAPSHOT_FRESH 4
+
+static void rects_init(struct snapshot_rects *const rects) {
+	rects->len = 64;
+	rects->num = 0;
+	rects->pos_x = easy_malloc(sizeof(game_scalar) * rects->len);
+	rects->pos_y = easy_malloc(sizeof(game_scalar) * rects->len);
+	rects->size_x = easy_malloc(sizeof(game_scalar) * rects->len);
+	rects->size_y = easy_malloc(sizeof(game_scalar) * rects->len);
+}
+
+static void rects_deinit(struct snapshot_rects *const rects) {
+	easy_free(rects->pos_x);
+	easy_free(rects->pos_y);
+	easy_free(rects->size_x);
+	easy_free(rects->size_y);
+}
+
+// Make room for `num` rects. Returns true if the arrays were reallocated
+static bool rects_reserve(
+	struct snapshot_rects *const rects,
+	const unsigned int num)
+{
+	if (num <= rects->len) {
+		return false;
+	}
+
+	rects->len = num * 2;
+	rects->pos_x = easy_realloc(rects->pos_x,
+		sizeof(game_scalar) * rects->len);
+	rects->pos_y = easy_realloc(rects->pos_y,
+		sizeof(game_scalar) * rects->len);
+	rects->size_x = easy_realloc(rects->size_x,
+		sizeof(game_scalar) * rects->len);
+	rects->size_y = easy_realloc(rects->size_y,
+		sizeof(game_scalar) * rects->len);
+
+	return true;
+}
+
+static void rects_set(
+	struct snapshot_rects *const rects,
+	const unsigned int i,
+	const game_scalar pos_x,
+	const game_scalar pos_y,
+	const game_scalar size_x,
+	const game_scalar size_y)
+{
+	rects->pos_x[i] = pos_x;
+	rects->pos_y[i] = pos_y;
+	rects->size_x[i] = size_x;
+	rects->size_y[i] = size_y;
+}
+
+void snapshot_init(struct snapshot *const snapshot) {
+	snapshot->sequence = 0;
+	snapshot->time = 0;
+	snapshot->input_sequence = 0;
+
+	snapshot->viewport_center_x = 0.0;
+	snapshot->viewport_center_y = 0.0;
+	snapshot->viewport_size_x = 1.0;
+	snapshot->viewport_size_y = 1.0;
+
+	snapshot->play_area_origin_x = 0.0;
+	snapshot->play_area_origin_y = 0.0;
+	snapshot->play_area_size_x = 0.0;
+	snapshot->play_area_size_y = 0.0;
+
+	snapshot->paddle = (struct paddle) {0};
+
+	rects_init(&snapshot->balls);
+
+	rects_init(&snapshot->bricks);
+	snapshot->brick_tex_indices = easy_malloc(
+		sizeof(uint8_t) * snapshot->bricks.len);
+	snapshot->brick_tex_x_props = easy_malloc(
+		sizeof(game_scalar) * snapshot->bricks.len);
+	snapshot->brick_tex_y_props = easy_malloc(
+		sizeof(game_scalar) * snapshot->bricks.len);
+	snapshot->brick_tex_x_speeds = easy_malloc(
+		sizeof(game_scalar) * snapshot->bricks.len);
+	snapshot->brick_tex_y_speeds = easy_malloc(
+		sizeof(game_scalar) * snapshot->bricks.len);
+	snapshot->brick_tex_ws = easy_malloc(sizeof(int) * snapshot->bricks.len);
+	snapshot->brick_tex_hs = easy_malloc(sizeof(int) * snapshot->bricks.len);
+	snapshot->brick_scroll_ns = 0;
+
+	rects_init(&snapshot->particles);
+	snapshot->particle_colors = easy_malloc(
+		sizeof(SDL_Color) * snapshot->particles.len);
+}
+
+void snapshot_deinit(struct snapshot *const snapshot) {
+	rects_deinit(&snapshot->balls);
+
+	rects_deinit(&snapshot->bricks);
+	easy_free(snapshot->brick_tex_indices);
+	easy_free(snapshot->brick_tex_x_props);
+	easy_free(snapshot->brick_tex_y_props);
+	easy_free(snapshot->brick_tex_x_speeds);
+	easy_free(snapshot->brick_tex_y_speeds);
+	easy_free(snapshot->brick_tex_ws);
+	easy_free(snapshot->brick_tex_hs);
+
+	rects_deinit(&snapshot->particles);
+	easy_free(snapshot->particle_colors);
+}
+
+void snapshot_capture(
+	struct snapshot *const snapshot,
+	const struct game *const game)
+{
+	snapshot->time = nsec_time();
+
+	snapshot->viewport_center_x = game->viewport_center_x;
+	snapshot->viewport_center_y = game->viewport_center_y;
+	snapshot->viewport_size_x = game->viewport_size_x;
+	snapshot->viewport_size_y = game->viewport_size_y;
+
+	snapshot->play_area_origin_x = game->play_area_origin_x;
+	snapshot->play_area_origin_y = game->play_area_origin_y;
+	snapshot->play_area_size_x = game->play_area_size_x;
+	snapshot->play_area_size_y = game->play_area_size_y;
+
+	snapshot->paddle = game->paddle;
+
+	// Balls
+	rects_reserve(&snapshot->balls, game->num_balls);
+	snapshot->balls.num = game->num_balls;
+
+	for (unsigned int i = 0; i < game->num_balls; i += 1) {
+		const struct ball *const ball = game->balls[i];
+
+		rects_set(&snapshot->balls, i,
+			ball->pos_x, ball->pos_y, ball->size_x, ball->size_y);
+	}
+
+	// Bricks
+	if (rects_reserve(&snapshot->bricks, game->num_bricks)) {
+		const unsigned int len = snapshot->bricks.len;
+
+		snapshot->brick_tex_indices = easy_realloc(
+			snapshot->brick_tex_indices, sizeof(uint8_t) * len);
+		snapshot->brick_tex_x_props = easy_realloc(
+			snapshot->brick_tex_x_props, sizeof(game_scalar) * len);
+		snapshot->brick_tex_y_props = easy_realloc(
+			snapshot->brick_tex_y_props, sizeof(game_scalar) * len);
+		snapshot->brick_tex_x_speeds = easy_realloc(
+			snapshot->brick_tex_x_speeds, sizeof(game_scalar) * len);
+		snapshot->brick_tex_y_speeds = easy_realloc(
+			snapshot->brick_tex_y_speeds, sizeof(game_scalar) * len);
+		snapshot->brick_tex_ws = easy_realloc(
+			snapshot->brick_tex_ws, sizeof(int) * len);
+		snapshot->brick_tex_hs = easy_realloc(
+			snapshot->brick_tex_hs, sizeof(int) * len);
+	}
+	snapshot->bricks.num = game->num_bricks;
+	snapshot->brick_scroll_ns = game->brick_scroll_ns;
+
+	for (unsigned int i = 0; i < game->num_bricks; i += 1) {
+		const struct brick *const brick = game->bricks[i];
+
+		rects_set(&snapshot->bricks, i,
+			brick->pos_x, brick->pos_y, brick->size_x, brick->size_y);
+
+		snapshot->brick_tex_indices[i] = brick->inner_tex_index;
+		snapshot->brick_tex_x_props[i] = brick->inner_tex_x_prop;
+		snapshot->brick_tex_y_props[i] = brick->inner_tex_y_prop;
+		snapshot->brick_tex_x_speeds[i] = brick->inner_tex_x_prop_speed;
+		snapshot->brick_tex_y_speeds[i] = brick->inner_tex_y_prop_speed;
+		snapshot->brick_tex_ws[i] = brick->inner_tex_w;
+		snapshot->brick_tex_hs[i] = brick->inner_tex_h;
+	}
+
+	// Particles
+	// Only the ones in the viewport are drawn, so only they are copied
+	if (rects_reserve(&snapshot->particles, game->particles.num)) {
+		snapshot->particle_colors = easy_realloc(snapshot->particle_colors,
+			sizeof(SDL_Color) * snapshot->particles.len);
+	}
+
+	const double view_left =
+		game->viewport_center_x - game->viewport_size_x / 2.0;
+	const double view_right = view_left + game->viewport_size_x;
+	const double view_bottom =
+		game->viewport_center_y - game->viewport_size_y / 2.0;
+	const double view_top = view_bottom + game->viewport_size_y;
+
+	unsigned int num_shown = 0;
+
+	for (unsigned int i = 0; i < game->particles.num; i += 1) {
+		const struct particle *const particle =
+			particles_get(&game->particles, i);
+
+		game_scalar pos_x;
+		game_scalar pos_y;
+		particles_position(&game->particles, particle, &pos_x, &pos_y);
+
+		// `pos_y` is the top edge
+		if (pos_x > view_right || pos_x + particle->size_x < view_left
+			|| pos_y < view_bottom || pos_y - particle->size_y > view_top)
+		{
+			continue;
+		}
+
+		rects_set(&snapshot->particles, num_shown,
+			pos_x, pos_y, particle->size_x, particle->size_y);
+
+		snapshot->particle_colors[num_shown] = (SDL_Color) {
+			.r = particle->r,
+			.g = particle->g,
+			.b = particle->b,
+			.a = particle->a
+		};
+
+		num_shown += 1;
+	}
+
+	snapshot->particles.num = num_shown;
+}
+
+void snapshot_brick_src_rects(
+	const struct snapshot *const snapshot,
+	const struct game_textures *const textures,
+	game_scalar *const phases,
+	SDL_Rect *const out)
+{
+	const unsigned int num = snapshot->bricks.num;
+	const game_scalar time = (game_scalar)snapshot->brick_scroll_ns;
+
+	const game_scalar *const x_props = snapshot->brick_tex_x_props;
+	const game_scalar *const y_props = snapshot->brick_tex_y_props;
+	const game_scalar *const x_speeds = snapshot->brick_tex_x_speeds;
+	const game_scalar *const y_speeds = snapshot->brick_tex_y_speeds;
+	game_scalar *const x_phases = phases;
+	game_scalar *const y_phases = phases + num;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const game_scalar x = x_props[i] + x_speeds[i] * time;
+		const game_scalar y = y_props[i] + y_speeds[i] * time;
+
+		// Wrap into [0, 1). Truncation rounds towards 0, so negative
+		//  values are left in (-1, 0] and need 1 added
+		game_scalar x_phase = x - (int)x;
+		game_scalar y_phase = y - (int)y;
+		x_phase += (x_phase < 0);
+		y_phase += (y_phase < 0);
+
+		x_phases[i] = x_phase;
+		y_phases[i] = y_phase;
+	}
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const unsigned int tex = snapshot->brick_tex_indices[i];
+		const int w = snapshot->brick_tex_ws[i];
+		const int h = snapshot->brick_tex_hs[i];
+
+		out[i] = (SDL_Rect) {
+			.x = x_phases[i] * (textures->brick_ws[tex] - w),
+			.y = y_phases[i] * (textures->brick_hs[tex] - h),
+			.w = w,
+			.h = h
+		};
+	}
+}
+
+void snapshot_buffer_init(struct snapshot_buffer *const buffer) {
+	for (unsigned int i = 0; i < 3; i += 1) {
+		snapshot_init(&buffer->snapshots[i]);
+	}
+
+	buffer->back = 0;
+	buffer->num_published = 0;
+	SDL_AtomicSet(&buffer->middle, 1);
+	buffer->front = 2;
+}
+
+void snapshot_buffer_deinit(struct snapshot_buffer *const buffer) {
+	for (unsigned int i = 0; i < 3; i += 1) {
+		snapshot_deinit(&buffer->snapshots[i]);
+	}
+}
+
+struct snapshot *snapshot_buffer_back(struct snapshot_buffer *const buffer) {
+	return &buffer->snapshots[buffer->back];
+}
+
+void snapshot_buffer_publish(struct snapshot_buffer *const buffer) {
+	buffer->num_published += 1;
+	buffer->snapshots[buffer->back].sequence = buffer->num_published;
+
+	// Everything written to the back snapshot must be visible
+	//  before the reader can take it
+	SDL_MemoryBarrierRelease();
+
+	const int old = SDL_AtomicSet(
+		&buffer->middle, buffer->back | SNAPSHOT_FRESH);
+
+	buffer->back = old & ~SNAPSHOT_FRESH;
+}
+
+const struct snapshot *snapshot_buffer_acquire(
+	struct snapshot_buffer *const buffer)
+{
+	if (SDL_AtomicGet(&buffer->middle) & SNAPSHOT_FRESH) {
+		const int old = SDL_AtomicSet(&buffer->middle, buffer->front);
+
+		SDL_MemoryBarrierAcquire();
+
+		buffer->front = old & ~SNAPSHOT_FRESH;
+	}
+
+	return &buffer->snapshots[buffer->front];
+}
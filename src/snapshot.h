@@ -0,0 +1,119 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Copies of the game state for drawing, handed from the simulation
+//  thread to the render thread through a triple buffer
+// The simulation writes one snapshot while the renderer reads another,
+//  and a third holds the newest complete one, so neither side waits
+
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rects as separate arrays so they can go straight to `game_viewport_rects`
+struct snapshot_rects {
+	unsigned int len;// Allocated length of each array
+	unsigned int num;
+	game_scalar *pos_x;
+	game_scalar *pos_y;
+	game_scalar *size_x;
+	game_scalar *size_y;
+};
+
+struct snapshot {
+	uint64_t sequence;// Counts up with every `snapshot_buffer_publish`
+	uint64_t time;// `nsec_time` when captured
+	// Newest input applied to the game (see latency.h). Set by the caller
+	int input_sequence;
+
+	double viewport_center_x;
+	double viewport_center_y;
+	double viewport_size_x;
+	double viewport_size_y;
+
+	double play_area_origin_x;
+	double play_area_origin_y;
+	double play_area_size_x;
+	double play_area_size_y;
+
+	struct paddle paddle;
+
+	struct snapshot_rects balls;
+
+	struct snapshot_rects bricks;
+	// Per brick. Same allocated length as `bricks`
+	uint8_t *brick_tex_indices;// Into `game_textures.bricks`
+	game_scalar *brick_tex_x_props;
+	game_scalar *brick_tex_y_props;
+	game_scalar *brick_tex_x_speeds;
+	game_scalar *brick_tex_y_speeds;
+	int *brick_tex_ws;
+	int *brick_tex_hs;
+	uint64_t brick_scroll_ns;
+
+	// Only the particles inside the viewport
+	struct snapshot_rects particles;
+	// Per particle. Same allocated length as `particles`
+	SDL_Color *particle_colors;
+};
+
+void snapshot_init(struct snapshot *const snapshot);
+
+void snapshot_deinit(struct snapshot *const snapshot);
+
+// Copy everything that is drawn from `game` into `snapshot`
+void snapshot_capture(
+	struct snapshot *const snapshot,
+	const struct game *const game);
+
+// Where each brick's texture has scrolled to: the source rect to copy
+//  from level 0 of `game_textures.brick_mips[brick_tex_indices[i]]`
+//  for brick i (see `mip_rect` for the other levels)
+// `phases` is scratch space for 2 * `bricks.num` values
+// One pass over plain arrays with no branches or calls, so that the
+//  compiler can vectorize it, then one pass to make the rects
+void snapshot_brick_src_rects(
+	const struct snapshot *const snapshot,
+	const struct game_textures *const textures,
+	game_scalar *const phases,
+	SDL_Rect *const out);
+
+// Lock-free triple buffer of snapshots for one writer and one reader
+struct snapshot_buffer {
+	struct snapshot snapshots[3];
+
+	// Index of the middle snapshot, plus `SNAPSHOT_FRESH` if the
+	//  writer has published it and the reader has not taken it yet
+	SDL_atomic_t middle;
+
+	int back;// Only used by the writer
+	uint64_t num_published;// Only used by the writer
+	int front;// Only used by the reader
+};
+
+void snapshot_buffer_init(struct snapshot_buffer *const buffer);
+
+void snapshot_buffer_deinit(struct snapshot_buffer *const buffer);
+
+// Writer: the snapshot to fill in next
+struct snapshot *snapshot_buffer_back(struct snapshot_buffer *const buffer);
+
+// Writer: make the back snapshot the newest one. Never waits
+void snapshot_buffer_publish(struct snapshot_buffer *const buffer);
+
+// Reader: the newest published snapshot. Stays valid and unchanged
+//  until the next call. Never waits
+const struct snapshot *snapshot_buffer_acquire(
+	struct snapshot_buffer *const buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+#include "sweep.h"
+
+#include <math.h>
+
+void sweep_sort(
+	struct ball *const *const balls,
+	unsigned int *const order,
+	struct sweep_box *const boxes,
+	const unsigned int num)
+{
+	for (unsigned int i = 0; i < num; i += 1) {
+		const struct ball *const ball = balls[order[i]];
+
+		boxes[i] = (struct sweep_box) {
+			.left = ball->pos_x,
+			.right = ball->pos_x + ball->size_x,
+			.bottom = ball->pos_y - ball->size_y,
+			.top = ball->pos_y
+		};
+	}
+
+	for (unsigned int i = 1; i < num; i += 1) {
+		const unsigned int index = order[i];
+		const struct sweep_box box = boxes[i];
+
+		unsigned int j = i;
+
+		while (j > 0 && boxes[j - 1].left > box.left) {
+			order[j] = order[j - 1];
+			boxes[j] = boxes[j - 1];
+			j -= 1;
+		}
+
+		order[j] = index;
+		boxes[j] = box;
+	}
+}
+
+unsigned int sweep_collide(
+	struct ball *const *const balls,
+	const unsigned int *const order,
+	const struct sweep_box *const boxes,
+	const unsigned int num)
+{
+	unsigned int num_pairs = 0;
+
+	for (unsigned int i = 0; i < num; i += 1) {
+		const struct sweep_box a_box = boxes[i];
+
+		// Every ball after `a` whose left edge was left of `a`'s right edge
+		//  overlapped `a` on the x-axis. `boxes` stays sorted while
+		//  bounces move the balls
+		for (unsigned int j = i + 1; j < num; j += 1) {
+			const struct sweep_box *const b_box = &boxes[j];
+
+			if (b_box->left >= a_box.right) {
+				break;
+			}
+
+			// Most of them are nowhere near on the y-axis
+			if (b_box->bottom >= a_box.top || b_box->top <= a_box.bottom) {
+				continue;
+			}
+
+			if (sweep_collide_pair(balls[order[i]], balls[order[j]])) {
+				num_pairs += 1;
+			}
+		}
+	}
+
+	return num_pairs;
+}
+
+bool sweep_collide_pair(struct ball *const a, struct ball *const b) {
+	const double a_right = a->pos_x + a->size_x;
+	const double b_right = b->pos_x + b->size_x;
+	const double a_bottom = a->pos_y - a->size_y;
+	const double b_bottom = b->pos_y - b->size_y;
+
+	const double overlap_x = fmin(a_right, b_right) - fmax(a->pos_x, b->pos_x);
+	const double overlap_y = fmin(a->pos_y, b->pos_y) - fmax(a_bottom, b_bottom);
+
+	if (overlap_x <= 0.0 || overlap_y <= 0.0) {
+		return false;
+	}
+
+	// Separate along the axis with the least overlap
+	//  and swap the velocities along that axis (equal mass elastic bounce)
+	if (overlap_x < overlap_y) {
+		const double a_center_x = a->pos_x + (a->size_x * 0.5);
+		const double b_center_x = b->pos_x + (b->size_x * 0.5);
+		// -1.0 if `a` is left of `b`, else 1.0
+		const double dir = (a_center_x < b_center_x) ? -1.0 : 1.0;
+
+		a->pos_x += dir * overlap_x * 0.5;
+		b->pos_x -= dir * overlap_x * 0.5;
+
+		// Only bounce if they are moving towards each other
+		if ((a->vel_x - b->vel_x) * dir < 0.0) {
+			const double vel_x = a->vel_x;
+			a->vel_x = b->vel_x;
+			b->vel_x = vel_x;
+		}
+	}
+	else {
+		const double a_center_y = a->pos_y - (a->size_y * 0.5);
+		const double b_center_y = b->pos_y - (b->size_y * 0.5);
+		// -1.0 if `a` is below `b`, else 1.0
+		const double dir = (a_center_y < b_center_y) ? -1.0 : 1.0;
+
+		a->pos_y += dir * overlap_y * 0.5;
+		b->pos_y -= dir * overlap_y * 0.5;
+
+		if ((a->vel_y - b->vel_y) * dir < 0.0) {
+			const double vel_y = a->vel_y;
+			a->vel_y = b->vel_y;
+			b->vel_y = vel_y;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,58 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+// Sort and sweep broadphase for ball-ball collisions
+// Balls are kept sorted by their left edge (x-axis).
+// The order from the previous frame is kept so that re-sorting is cheap.
+// Only the x-axis is swept, so at a fixed density each ball is tested
+//  against the balls in a column as tall as the play area: O(n^1.5)
+//  overall. Fine for the hundreds of balls a game has, but see
+//  bench_sweep.bin for how it grows past that.
+// Balls are taller than they are wide, so x overlaps less than y would.
+
+#include "game.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Edges of a ball as of `sweep_sort`
+struct sweep_box {
+	game_scalar left;
+	game_scalar right;
+	game_scalar bottom;
+	game_scalar top;
+};
+
+// Sort `order` (indices into `balls`) by the left edge of each ball
+// Uses insertion sort, which is close to O(n) when `order` is still
+//  mostly sorted from the previous frame
+// Sets `boxes[i]` to the edges of ball `order[i]` as of now
+void sweep_sort(
+	struct ball *const *const balls,
+	unsigned int *const order,
+	struct sweep_box *const boxes,
+	const unsigned int num);
+
+// Sweep over `order` and `boxes` (from `sweep_sort`)
+//  and bounce every pair of balls that overlap
+// Bouncing moves balls, so pairs are found with the edges from
+//  `sweep_sort` and only then tested and bounced where the balls are
+//  now: the same as finding every pair first and bouncing them after
+// Returns the number of pairs that were bounced
+unsigned int sweep_collide(
+	struct ball *const *const balls,
+	const unsigned int *const order,
+	const struct sweep_box *const boxes,
+	const unsigned int num);
+
+// Bounce balls `a` and `b` off of each other if they overlap
+// Both balls are treated as having the same mass
+// Returns true if they overlapped
+bool sweep_collide_pair(struct ball *const a, struct ball *const b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif